@@ -1,5 +1,5 @@
 #include <stdio.h>
-#include <random>
+#include <cmath>
 
 #include "discrete.pb.h"
 #include "action.h"
@@ -9,6 +9,9 @@
 #include "vector.h"
 #include "decision_table.h"
 #include "decision.h"
+#include "eval_context.h"
+#include "constraints.h"
+#include "rng.h"
 
 static void update(Action *a, const Action *b) {
   switch (b->type) {
@@ -51,47 +54,46 @@ Action make_pass_action(int pass_receiver) {
   return a;
 }
 
+bool valid_move_pos(int robot, Vector pos, const State &state,
+                    const DecisionTable &table) {
+  MoveConstraints c;
+  move_constraints_init(c, robot, state, table);
+  return move_feasible(c, pos);
+}
+
+// draws rejected before the last one is projected instead
+static constexpr int MAX_MOVE_TRIES = 16;
+
 Action gen_move_action(int robot, const State &state,
                        struct DecisionTable &table) {
+  Rng &rng = thread_rng();
+  MoveConstraints c;
+  move_constraints_init(c, robot, state, table);
+
   Vector pos;
-  float r_radius;
-  Player p = PLAYER_OF(robot);
-
-again:
-  r_radius = 0;
-  switch (rand() % 3) {
-  case 0:
-    r_radius = MOVE_RADIUS_0;
-    break;
-  case 1:
-    r_radius = MOVE_RADIUS_1;
-    break;
-  case 2:
-    r_radius = MOVE_RADIUS_2;
-    break;
-  }
-  pos = rand_vector_bounded(state.robots[robot], r_radius, FIELD_WIDTH / 2,
-                            FIELD_HEIGHT / 2);
-
-  // XXX: do not allow __ANYONE__ (temporary) to enter the defense area
-  if (robot % N_ROBOTS != 0 && norm(GOAL_POS(p) - pos) <= DEFENSE_RADIUS)
-    // if (norm(GOAL_POS(p) - pos) <= DEFENSE_RADIUS)
-    goto again;
-
-  // too close to the ball
-  if (norm2(state.ball - pos) <= SQ(ROBOT_RADIUS + BALL_RADIUS))
-    goto again;
-
-  FOR_EVERY_ROBOT(i) if (i != robot) {
-    if (norm2(state.robots[i] - pos) <= SQ(2 * ROBOT_RADIUS))
-      goto again;
-    if (norm2(table.move[i].move_pos - pos) <= SQ(2 * ROBOT_RADIUS))
-      goto again;
+  FOR_N(tries, MAX_MOVE_TRIES) {
+    float r_radius = 0;
+    switch (rng_int(rng, 3)) {
+    case 0:
+      r_radius = MOVE_RADIUS_0;
+      break;
+    case 1:
+      r_radius = MOVE_RADIUS_1;
+      break;
+    case 2:
+      r_radius = MOVE_RADIUS_2;
+      break;
+    }
+    // uniform in angle and distance, so denser close to the robot
+    float theta = rng_uniform(rng, -M_PI, M_PI);
+    float rand_r = rng_uniform(rng, 0, r_radius);
+    pos = state.robots[robot] +
+          Vector(rand_r * cos(theta), rand_r * sin(theta));
+    if (move_feasible(c, pos))
+      return make_move_action(pos);
   }
-
-  // TODO: check agains move table maybe?
-
-  return make_move_action(pos);
+  // boxed in, moved to the closest allowed spot
+  return make_move_action(move_project(c, pos));
 }
 
 // XXX: how should the table me used here??
@@ -101,13 +103,18 @@ again:
 Action gen_kick_action(int robot, const State &state, struct DecisionTable &) {
   // XXX: can table help in any way? avoid maybe?
 
-  float ky, kx = GOAL_X(ENEMY_OF(robot));
-
   int gaps_count;
   Segment gaps[N_ROBOTS * 2]; // this should be enough
   discover_gaps_from_pos(state, state.ball, ENEMY_OF(robot), gaps, &gaps_count,
                          robot);
 
+  return kick_action_of_gaps(ENEMY_OF(robot), gaps, gaps_count);
+}
+
+Action kick_action_of_gaps(Player goal_player, const Segment *gaps,
+                           int gaps_count) {
+  float ky, kx = GOAL_X(goal_player);
+
   float max_len = 0.0;
   FOR_N(i, gaps_count) {
     float len = gaps[i].u - gaps[i].d;
@@ -120,7 +127,9 @@ Action gen_kick_action(int robot, const State &state, struct DecisionTable &) {
   return make_kick_action({kx, ky});
 }
 
-Action gen_pass_action(int robot, const State &state, DecisionTable &table) {
+Action gen_pass_action(const EvalContext &ctx, DecisionTable &table) {
+  auto &state = *ctx.state;
+  int robot = ctx.rwb;
   Player player = PLAYER_OF(robot);
   TeamFilter receivers;
   filter_out(receivers, robot);
@@ -128,10 +137,7 @@ Action gen_pass_action(int robot, const State &state, DecisionTable &table) {
   if (receivers.count > 0) {
 
     // select a random receiver
-    static std::random_device rd;
-    static std::mt19937_64 gen(rd());
-    std::uniform_int_distribution<> dis(0, receivers.count - 1);
-    int sel = dis(gen);
+    int sel = rng_int(thread_rng(), receivers.count);
     int rcv = -1;
     FOR_TEAM_ROBOT_IN(i, player, receivers) {
       if (sel-- == 0) {
@@ -145,19 +151,18 @@ Action gen_pass_action(int robot, const State &state, DecisionTable &table) {
     // in case there isn't any possible pass
     // for the robot with ball, we'll make it move or kick
     if (KICK_IF_NO_PASS)
-      return gen_kick_action(robot, state, table);
+      return ctx.kick_action;
     else
       return gen_move_action(robot, state, table);
   }
 }
 
-Action gen_primary_action(int robot, const State &state, DecisionTable &table,
-                          bool kick) {
-  return kick ? gen_kick_action(robot, state, table)
-              : gen_pass_action(robot, state, table);
+Action gen_primary_action(const EvalContext &ctx, DecisionTable &table) {
+  return ctx.kick ? ctx.kick_action : gen_pass_action(ctx, table);
 }
 
-void apply_to_state(Action action, int robot, State *state) {
+template <typename T>
+void apply_to_state(Action action, int robot, BasicState<T> *state) {
   switch (action.type) {
 
   case MOVE: {
@@ -180,3 +185,6 @@ void apply_to_state(Action action, int robot, State *state) {
     break;
   }
 }
+
+template void apply_to_state(Action, int, State *);
+template void apply_to_state(Action, int, BasicState<Dual> *);
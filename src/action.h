@@ -3,6 +3,8 @@
 
 #include "vector.h"
 #include "player.h"
+#include "segment.h"
+#include "state.h"
 
 enum ActionType { NONE = 0x0, MOVE = 0x1, PASS = 0x2, KICK = 0x4 };
 
@@ -23,19 +25,28 @@ Action make_move_action(Vector move_pos);
 Action make_kick_action(Vector kick_pos);
 Action make_pass_action(int pass_receiver);
 
-struct State;
 struct DecisionTable;
 struct Decision;
+struct EvalContext;
+
+// whether robot is allowed to move to pos: inside the field, out of the
+// defense area, and not over the ball or other robots (current or planned)
+bool valid_move_pos(int robot, Vector pos, const State &state,
+                    const DecisionTable &table);
+
 Action gen_move_action(int robot, const State &state, DecisionTable &table);
 Action gen_kick_action(int robot, const State &state, DecisionTable &table);
-Action gen_pass_action(int robot, const State &state, DecisionTable &table);
 
-// TODO: consider refactoring this function to a better form
-// int gen_primary_action(bool kick, const State &state, Player player,
-// DecisionTable &table, Decision &decision);
-Action gen_primary_action(int robot, const State &state, DecisionTable &table,
-                          bool kick);
+// kick to the middle of the largest of the gaps on the goal of goal_player
+Action kick_action_of_gaps(Player goal_player, const Segment *gaps,
+                           int gaps_count);
+
+// these act for the robot with the ball of the context, which must be ours
+Action gen_pass_action(const EvalContext &ctx, DecisionTable &table);
+Action gen_primary_action(const EvalContext &ctx, DecisionTable &table);
 
-void apply_to_state(Action action, int robot, State *state);
+// instantiated for float and Dual
+template <typename T>
+void apply_to_state(Action action, int robot, BasicState<T> *state);
 
 #endif
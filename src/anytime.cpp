@@ -0,0 +1,44 @@
+#include "anytime.h"
+#include "utils.h"
+
+static constexpr int FRESH = 0x4;
+
+void anytime_begin(AnytimeDecision &anytime, float value,
+                   const Decision &decision) {
+  anytime.generation.fetch_add(1, std::memory_order_release);
+  anytime_publish(anytime, MAX_DECISION_THREADS, value, decision);
+}
+
+void anytime_publish(AnytimeDecision &anytime, int slot, float value,
+                     const Decision &decision) {
+  auto &s = anytime.slots[slot];
+  auto &entry = s.buffers[s.back];
+  entry.generation = anytime.generation.load(std::memory_order_relaxed);
+  entry.value = value;
+  entry.decision = decision;
+  s.back = s.middle.exchange(s.back | FRESH, std::memory_order_acq_rel) &
+           ~FRESH;
+}
+
+bool anytime_read(AnytimeDecision &anytime, Decision *decision) {
+  int generation = anytime.generation.load(std::memory_order_acquire);
+  const AnytimeEntry *best = nullptr;
+
+  FOR_N(i, MAX_DECISION_THREADS + 1) {
+    auto &s = anytime.slots[i];
+    if (s.middle.load(std::memory_order_relaxed) & FRESH)
+      s.front = s.middle.exchange(s.front, std::memory_order_acq_rel) & ~FRESH;
+
+    auto &entry = s.buffers[s.front];
+    if (entry.generation != generation)
+      continue;
+    if (best == nullptr || entry.value > best->value)
+      best = &entry;
+  }
+
+  if (best == nullptr)
+    return false;
+
+  *decision = best->decision;
+  return true;
+}
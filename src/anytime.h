@@ -0,0 +1,49 @@
+#ifndef ANYTIME_H
+#define ANYTIME_H
+
+#include <atomic>
+
+#include "consts.h"
+#include "decision.h"
+
+// Lock free board where the search threads publish their best decision as
+// soon as it improves, so a reply doesn't wait for decide() to return.
+// Every search thread owns a slot, which is a triple buffer (single writer,
+// single reader), and the reader picks the best decision published on the
+// current generation (one generation per decide() call). A generation starts
+// with the decision the previous one left, on a slot of its own, so a reply
+// right after it starts never carries a worse one.
+
+struct AnytimeEntry {
+  int generation = -1;
+  float value = 0.0;
+  Decision decision;
+};
+
+struct AnytimeSlot {
+  AnytimeEntry buffers[3];
+  // buffer last written, with a flag set until the reader takes it
+  std::atomic<int> middle{1};
+  int back = 0;  // only touched by the writer
+  int front = 2; // only touched by the reader
+};
+
+struct AnytimeDecision {
+  std::atomic<int> generation{0};
+  // one for each search thread, then the one of the seeds
+  AnytimeSlot slots[MAX_DECISION_THREADS + 1];
+};
+
+// start a new generation with decision worth value, what was published before
+// is ignored from now on
+void anytime_begin(AnytimeDecision &anytime, float value,
+                   const Decision &decision);
+
+void anytime_publish(AnytimeDecision &anytime, int slot, float value,
+                     const Decision &decision);
+
+// copy the best decision of the current generation, false if there is none,
+// must always be called from the same thread
+bool anytime_read(AnytimeDecision &anytime, Decision *decision);
+
+#endif
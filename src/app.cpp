@@ -21,11 +21,16 @@
 #include "id_table.h"
 #include "suggestions.h"
 #include "decision_source.h"
+#include "anytime.h"
+#include "packet_clock.h"
 
 static std::mutex state_mutex, decision_mutex, display_mutex;
 static Decision decision_min, decision_max;
 static State state, command_state;
 static Optimization optimization;
+static Minimax minimax;
+static AnytimeDecision anytime_decision;
+static PacketClock packet_clock;
 static IdTable id_table;
 static Suggestions suggestions;
 
@@ -44,10 +49,24 @@ static struct {
   int pps = 0;
   int mps = 0;
   float rpd = 0.0;
+  float pruned = 0.0;
+  // percentage of the candidates of the last decide per source
+  float allocation[N_SOURCES] = {};
+  // value the fine optimization added to the last decision
+  float fine_gain = 0.0;
+  // of the last minimax search, the cutoffs and pruned in percentage
+  float minimax_nodes_per_s = 0.0;
+  float minimax_cutoffs = 0.0;
+  float minimax_pruned = 0.0;
+  // nodes found on the transposition table and returned from it, percentages
+  // of the nodes looked up
+  float minimax_tt_hits = 0.0;
+  float minimax_tt_cutoffs = 0.0;
   float val = 0.0;
   float vals[W_SIZE] = {};
   bool has_val = false;
   float decision_val = 0.0;
+  unsigned decision_seed = 0;
 } display;
 
 static bool play_minimax = false, play_decision_once = false, eval_state = true,
@@ -117,6 +136,10 @@ void update_param_group(void) {
 
 void app_run(std::function<void(void)> loop_func, bool play_as_max) {
   state = uniform_rand_state();
+  optimization.anytime = &anytime_decision;
+  optimization.clock = &packet_clock;
+  minimax.anytime = &anytime_decision;
+  minimax.clock = &packet_clock;
   update_param_group();
 
   // Timer tmr;
@@ -130,6 +153,7 @@ void app_run(std::function<void(void)> loop_func, bool play_as_max) {
   std::atomic<int> req_count(0);
   std::atomic<int> dec_count(0);
   std::atomic<int> tram_count(0);
+  std::atomic<int> tpruned_count(0);
 
   std::thread count_thread([&]() {
     std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -138,12 +162,14 @@ void app_run(std::function<void(void)> loop_func, bool play_as_max) {
       int count = req_count.exchange(0);
       int dcount = dec_count.exchange(0);
       int rcount = tram_count.exchange(0);
+      int pcount = tpruned_count.exchange(0);
       {
         std::lock_guard<std::mutex> _(display_mutex);
         display.uptime = ++n_ticks;
         display.pps = count;
         display.mps = dcount;
         display.rpd = ((float)rcount) / dcount;
+        display.pruned = rcount > 0 ? 100.0 * pcount / rcount : 0.0;
       }
       if (CONSTANT_RATE) {
         if (dcount > 0)
@@ -189,6 +215,8 @@ void app_run(std::function<void(void)> loop_func, bool play_as_max) {
           std::string buffer_str((char *)buffer.data(), buffer.size());
           // we're stat maniac, count up the number of requests
           req_count++;
+          // and when they come, so the search can end right before the next
+          packet_clock_mark(packet_clock, std::chrono::steady_clock::now());
 
           // ok, time to parse that data
           UpdateMessage update;
@@ -203,11 +231,12 @@ void app_run(std::function<void(void)> loop_func, bool play_as_max) {
           }
 
           // update done, time to reply that request, remember?
-          // just like above we'll atomically copy the latest decision
-          // staright from the app, we don't want it to change while
-          // iterating over it
+          // prefer the best decision found so far by the running search,
+          // otherwise just like above we'll atomically copy the latest
+          // decision staright from the app, we don't want it to change
+          // while iterating over it
           Decision local_decision;
-          {
+          if (!anytime_read(anytime_decision, &local_decision)) {
             std::lock_guard<std::mutex> _(decision_mutex);
             if (play_as_max)
               local_decision = decision_max;
@@ -237,8 +266,6 @@ void app_run(std::function<void(void)> loop_func, bool play_as_max) {
   });
 
   std::thread decision_thread([&]() {
-    // single minimax instance, may make use of cache in the future
-    // Minimax minimax;
     State local_state;
     Decision local_decision_max, local_decision_min;
 
@@ -268,28 +295,66 @@ void app_run(std::function<void(void)> loop_func, bool play_as_max) {
             local_decision_min = valued_decision.decision;
             val = valued_decision.value;
           }
+          tpruned_count += optimization.pruned_count;
+          {
+            std::lock_guard<std::mutex> _(display_mutex);
+            FOR_N(s, N_SOURCES) {
+              display.allocation[s] =
+                  ram_count > 0
+                      ? 100.0 * optimization.source_count[s] / ram_count
+                      : 0.0;
+            }
+            display.fine_gain = optimization.fine_gain;
+          }
         } else {
-          // TODO: minimax decision
-          val = 0.0;
+          auto valued_decision =
+              minimax_decide(minimax, local_state, play_as_max ? MAX : MIN);
+          if (play_as_max)
+            local_decision_max = valued_decision.decision;
+          else
+            local_decision_min = valued_decision.decision;
+          val = valued_decision.value;
+          ram_count = minimax.stats.nodes;
+          {
+            std::lock_guard<std::mutex> _(display_mutex);
+            auto &stats = minimax.stats;
+            display.minimax_nodes_per_s =
+                minimax.seconds > 0 ? stats.nodes / minimax.seconds : 0.0;
+            display.minimax_cutoffs =
+                stats.expanded > 0 ? 100.0 * stats.cutoffs / stats.expanded
+                                   : 0.0;
+            display.minimax_pruned =
+                stats.leaves > 0 ? 100.0 * stats.pruned / stats.leaves : 0.0;
+            float probes = stats.tt_probes;
+            display.minimax_tt_hits =
+                probes > 0 ? 100.0 * stats.tt_hits / probes : 0.0;
+            display.minimax_tt_cutoffs =
+                probes > 0 ? 100.0 * stats.tt_cutoffs / probes : 0.0;
+          }
         }
 
         dec_count++;
         tram_count += ram_count;
         display.decision_count++;
         display.decision_val = val;
+        display.decision_seed =
+            MAX_DEPTH == 0 ? optimization.seed : minimax.seed;
+        if (LOG_DECISIONS)
+          printf("decide %i: seed %u, value %f, %i ramifications, %i pruned\n",
+                 n_ticks, display.decision_seed, val, ram_count,
+                 MAX_DEPTH == 0 ? optimization.pruned_count
+                                : (int)minimax.stats.pruned);
       }
 
       if (true || eval_state || eval_state_once) {
         eval_state_once = false;
-        if (MAX_DEPTH == 0) {
-          FOR_N(i, W_SIZE) display.vals[i] = 0.0;
-          display.val = evaluate_with_decision(
-              play_as_max ? MAX : MIN, local_state,
-              play_as_max ? local_decision_max : local_decision_min,
-              optimization.table, display.vals);
-        } else {
-          // TODO: use minimax decision table
-        }
+        Player player = play_as_max ? MAX : MIN;
+        FOR_N(i, W_SIZE) display.vals[i] = 0.0;
+        display.val = evaluate_with_decision(
+            player, local_state,
+            play_as_max ? local_decision_max : local_decision_min,
+            MAX_DEPTH == 0 ? optimization.table : minimax.table[player],
+            display.vals);
         display.has_val = true;
       }
 
@@ -386,7 +451,19 @@ void draw_app_status(void) {
     ImGui::Text("%.2f ramifications/decision", display.rpd);
   else
     ImGui::Text("%i decisions/s", display.mps);
+  if (PRUNE_EVALUATION)
+    ImGui::Text("%.1f%% evaluations pruned", display.pruned);
   ImGui::Text("decided val: %f", display.decision_val);
+  if (FINE_OPTIMIZE != NO_OPTIMIZE)
+    ImGui::Text("fine optimization gain: %f", display.fine_gain);
+  if (MAX_DEPTH > 0)
+    ImGui::Text("minimax: %.0f nodes/s, %.1f%% cutoffs, %.1f%% pruned",
+                display.minimax_nodes_per_s, display.minimax_cutoffs,
+                display.minimax_pruned);
+  if (MAX_DEPTH > 0 && TRANSPOSITION_TABLE)
+    ImGui::Text("transpositions: %.1f%% hits, %.1f%% cutoffs",
+                display.minimax_tt_hits, display.minimax_tt_cutoffs);
+  ImGui::Text("decision seed: %u", display.decision_seed);
   if (display.has_val)
     ImGui::Text("current val: %f", display.val);
   switch (decision_source) {
@@ -396,6 +473,9 @@ void draw_app_status(void) {
   case TABLE:
     ImGui::Text("decision from table");
     break;
+  case ELITE:
+    ImGui::Text("decision from elite");
+    break;
   case FULL_RANDOM:
     ImGui::Text("decision from full random");
     break;
@@ -407,6 +487,12 @@ void draw_app_status(void) {
     ImGui::Text("no decision source");
     break;
   }
+  ImGui::Text("allocation: %.0f%% sugg, %.0f%% table, %.0f%% elite",
+              display.allocation[SUGGESTION], display.allocation[TABLE],
+              display.allocation[ELITE]);
+  ImGui::Text("            %.0f%% full, %.0f%% single",
+              display.allocation[FULL_RANDOM],
+              display.allocation[SINGLE_RANDOM]);
 #define SHOW_VAR(NAME) ImGui::Text(#NAME ": %f", display.vals[_##NAME]);
   SHOW_VAR(WEIGHT_BALL_POS);
   SHOW_VAR(WEIGHT_MOVE_DIST_MAX);
@@ -429,6 +515,14 @@ void draw_app_status(void) {
 }
 
 #define PARAMS_FILE_HEADER "[AI params version 1]"
+#define SEP " = "
+// how every PARAM type is written and read, bools go through an int
+#define MODE_bool "%i"
+#define MODE_int "%i"
+#define MODE_float "%f"
+#define SCAN_bool int
+#define SCAN_int int
+#define SCAN_float float
 void app_save_params(const char *filename) {
   auto file = fopen(filename, "w");
   if (!file) {
@@ -436,43 +530,15 @@ void app_save_params(const char *filename) {
     return;
   }
   fprintf(file, PARAMS_FILE_HEADER "\n");
-#define SEP " = "
-#define SAVE_PARAM(MODE, NAME) fprintf(file, #NAME SEP MODE "\n", NAME)
-  SAVE_PARAM("%i", CONSTANT_RATE);
-  SAVE_PARAM("%i", KICK_IF_NO_PASS);
-  if (CONSTANT_RATE)
-    SAVE_PARAM("%i", DECISION_RATE);
-  else
-    SAVE_PARAM("%i", RAMIFICATION_NUMBER);
-  SAVE_PARAM("%i", FULL_CHANGE_PERCENTAGE);
-  SAVE_PARAM("%i", MAX_DEPTH);
-  SAVE_PARAM("%f", KICK_POS_VARIATION);
-  SAVE_PARAM("%f", MIN_GAP_TO_KICK);
-  SAVE_PARAM("%f", DESIRED_PASS_DIST);
-  SAVE_PARAM("%f", WEIGHT_BALL_POS);
-  SAVE_PARAM("%f", WEIGHT_MOVE_DIST_MAX);
-  SAVE_PARAM("%f", WEIGHT_MOVE_DIST_TOTAL);
-  SAVE_PARAM("%f", WEIGHT_MOVE_CHANGE);
-  SAVE_PARAM("%f", WEIGHT_PASS_CHANGE);
-  SAVE_PARAM("%f", WEIGHT_KICK_CHANGE);
-  SAVE_PARAM("%f", TOTAL_MAX_GAP_RATIO);
-  SAVE_PARAM("%f", WEIGHT_CLOSE_TO_BALL);
-  SAVE_PARAM("%f", WEIGHT_ENEMY_CLOSE_TO_BALL);
-  SAVE_PARAM("%f", WEIGHT_HAS_BALL);
-  SAVE_PARAM("%f", WEIGHT_ATTACK);
-  SAVE_PARAM("%f", WEIGHT_SEE_ENEMY_GOAL);
-  SAVE_PARAM("%f", WEIGHT_BLOCK_GOAL);
-  SAVE_PARAM("%f", WEIGHT_BLOCK_ATTACKER);
-  SAVE_PARAM("%f", WEIGHT_GOOD_RECEIVERS);
-  SAVE_PARAM("%f", WEIGHT_RECEIVERS_NUM);
-  SAVE_PARAM("%f", WEIGHT_ENEMY_RECEIVERS_NUM);
-  SAVE_PARAM("%f", DIST_GOAL_PENAL);
-  SAVE_PARAM("%f", DIST_GOAL_TO_PENAL);
-  SAVE_PARAM("%f", MOVE_RADIUS_0);
-  SAVE_PARAM("%f", MOVE_RADIUS_1);
-  SAVE_PARAM("%f", MOVE_RADIUS_2);
+  // only the one of DECISION_RATE and RAMIFICATION_NUMBER CONSTANT_RATE uses
+  const void *unused =
+      CONSTANT_RATE ? (const void *)&RAMIFICATION_NUMBER : &DECISION_RATE;
+#define SAVE_PARAM(TYPE, NAME, DEFAULT)                                        \
+  if ((const void *)&NAME != unused)                                           \
+    fprintf(file, #NAME SEP MODE_##TYPE "\n", NAME);
+  FOR_EVERY_PARAM(SAVE_PARAM)
+  SAVE_PARAM(int, DECISION_THREADS, 1)
 #undef SAVE_PARAM
-#undef SEP
   fclose(file);
 }
 
@@ -482,8 +548,6 @@ void app_load_params(const char *filename) {
     perror("Could not load params");
     return;
   }
-  int CONSTANT_RATE;
-  int KICK_IF_NO_PASS;
 
   char line[256];
   fgets(line, 256, file);
@@ -496,47 +560,25 @@ void app_load_params(const char *filename) {
 
   while (!feof(file)) {
     fgets(line, 256, file);
-#define SEP " = "
-#define LOAD_PARAM(MODE, NAME)                                                 \
-  if (!strncmp(line, #NAME, strlen(#NAME)))                                    \
-  sscanf(line, "%*s" SEP MODE, &NAME)
-    LOAD_PARAM("%i", CONSTANT_RATE);
-    LOAD_PARAM("%i", KICK_IF_NO_PASS);
-    LOAD_PARAM("%i", DECISION_RATE);
-    LOAD_PARAM("%i", RAMIFICATION_NUMBER);
-    LOAD_PARAM("%i", FULL_CHANGE_PERCENTAGE);
-    LOAD_PARAM("%i", MAX_DEPTH);
-    LOAD_PARAM("%f", KICK_POS_VARIATION);
-    LOAD_PARAM("%f", MIN_GAP_TO_KICK);
-    LOAD_PARAM("%f", DESIRED_PASS_DIST);
-    LOAD_PARAM("%f", WEIGHT_BALL_POS);
-    LOAD_PARAM("%f", WEIGHT_MOVE_DIST_MAX);
-    LOAD_PARAM("%f", WEIGHT_MOVE_DIST_TOTAL);
-    LOAD_PARAM("%f", WEIGHT_MOVE_CHANGE);
-    LOAD_PARAM("%f", WEIGHT_PASS_CHANGE);
-    LOAD_PARAM("%f", WEIGHT_KICK_CHANGE);
-    LOAD_PARAM("%f", TOTAL_MAX_GAP_RATIO);
-    LOAD_PARAM("%f", WEIGHT_CLOSE_TO_BALL);
-    LOAD_PARAM("%f", WEIGHT_ENEMY_CLOSE_TO_BALL);
-    LOAD_PARAM("%f", WEIGHT_HAS_BALL);
-    LOAD_PARAM("%f", WEIGHT_ATTACK);
-    LOAD_PARAM("%f", WEIGHT_SEE_ENEMY_GOAL);
-    LOAD_PARAM("%f", WEIGHT_BLOCK_GOAL);
-    LOAD_PARAM("%f", WEIGHT_BLOCK_ATTACKER);
-    LOAD_PARAM("%f", WEIGHT_GOOD_RECEIVERS);
-    LOAD_PARAM("%f", WEIGHT_RECEIVERS_NUM);
-    LOAD_PARAM("%f", WEIGHT_ENEMY_RECEIVERS_NUM);
-    LOAD_PARAM("%f", DIST_GOAL_PENAL);
-    LOAD_PARAM("%f", DIST_GOAL_TO_PENAL);
-    LOAD_PARAM("%f", MOVE_RADIUS_0);
-    LOAD_PARAM("%f", MOVE_RADIUS_1);
-    LOAD_PARAM("%f", MOVE_RADIUS_2);
+// the whole name and separator, so no name matches the lines of longer ones
+#define LOAD_PARAM(TYPE, NAME, DEFAULT)                                        \
+  if (!strncmp(line, #NAME SEP, strlen(#NAME SEP))) {                          \
+    SCAN_##TYPE value;                                                         \
+    if (sscanf(line, "%*s" SEP MODE_##TYPE, &value) == 1)                      \
+      NAME = value;                                                            \
+  }
+    FOR_EVERY_PARAM(LOAD_PARAM)
+    LOAD_PARAM(int, DECISION_THREADS, 1)
 #undef LOAD_PARAM
-#undef SEP
   }
-  ::CONSTANT_RATE = CONSTANT_RATE;
-  ::KICK_IF_NO_PASS = KICK_IF_NO_PASS;
 
 out:
   fclose(file);
 }
+#undef SCAN_float
+#undef SCAN_int
+#undef SCAN_bool
+#undef MODE_float
+#undef MODE_int
+#undef MODE_bool
+#undef SEP
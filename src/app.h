@@ -3,6 +3,8 @@
 
 #include <functional>
 
+#include "state.h"
+
 void app_run(std::function<void(void)> loop_func, bool play_as_max = true);
 void app_random();
 void app_decide_once();
@@ -24,7 +26,7 @@ void app_move_right();
 void app_save_params(const char *filename);
 void app_load_params(const char *filename);
 
-extern const struct State *app_state;
+extern const State *app_state;
 extern const struct Decision *app_decision_max;
 extern const struct Decision *app_decision_min;
 extern const struct DecisionTable *app_decision_table;
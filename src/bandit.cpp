@@ -0,0 +1,66 @@
+#include <cmath>
+#include <algorithm>
+
+#include "bandit.h"
+#include "utils.h"
+
+static bool is_stale(const SourceStats &s) {
+  return s.stale_ticks >= SOURCE_STALE_TICKS;
+}
+
+// upper confidence bound of the wins per sample
+static float ucb(const SourceStats &s, float total) {
+  return s.wins / s.samples +
+         SOURCE_EXPLORATION * std::sqrt(std::log(total + 1) / s.samples);
+}
+
+Allocation bandit_allocate(const SourceBandit &bandit, int group) {
+  Allocation alloc;
+  alloc.full_change_percentage = FULL_CHANGE_PERCENTAGE;
+  if (!ADAPTIVE_ALLOCATION)
+    return alloc;
+
+  auto &stats = bandit.stats[group];
+  // stale sources are still tried on one of every SOURCE_STALE_TICKS decides
+  bool probe = bandit.ticks % std::max(SOURCE_STALE_TICKS, 1) == 0;
+  alloc.suggestions = probe || !is_stale(stats[SUGGESTION]);
+  alloc.elite = probe || !is_stale(stats[ELITE]);
+
+  auto &full = stats[FULL_RANDOM];
+  auto &single = stats[SINGLE_RANDOM];
+  float percentage = FULL_CHANGE_PERCENTAGE;
+  if (full.samples > 0 && single.samples > 0) {
+    float total = full.samples + single.samples;
+    float f = ucb(full, total), s = ucb(single, total);
+    if (f + s > 0)
+      percentage = 100.0 * f / (f + s);
+  }
+
+  // when both are stale neither is dropped
+  bool drop = !probe && is_stale(full) != is_stale(single);
+  if (drop)
+    percentage = is_stale(full) ? 0.0 : 100.0;
+
+  alloc.full_change_percentage = percentage;
+  alloc.full_random = !(drop && is_stale(full));
+  alloc.single_random = !(drop && is_stale(single));
+  return alloc;
+}
+
+void bandit_update(SourceBandit &bandit, int group, const int *samples,
+                   DecisionSource winner) {
+  bandit.ticks++;
+
+  auto &stats = bandit.stats[group];
+  FOR_N(k, N_SOURCES) {
+    auto &s = stats[k];
+    s.samples = s.samples * SOURCE_DECAY + samples[k];
+    s.wins *= SOURCE_DECAY;
+    if (k == winner) {
+      s.wins += 1;
+      s.stale_ticks = 0;
+    } else if (samples[k] > 0) {
+      s.stale_ticks++;
+    }
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef BANDIT_H
+#define BANDIT_H
+
+#include "consts.h"
+#include "decision_source.h"
+
+constexpr int N_SOURCES = SINGLE_RANDOM + 1;
+constexpr int N_PARAM_GROUPS = 4;
+
+// Bandit spreading the candidates of decide() between decision sources.
+// Every source keeps, for each param group, decayed counts of the candidates
+// it got and of the decides it won. The random candidates are split between
+// FULL_RANDOM and SINGLE_RANDOM by their UCB score, each one tried getting at
+// least a candidate, suggestions and elite
+// seeds are only tried once in a while after SOURCE_STALE_TICKS decides
+// without a win.
+
+struct SourceStats {
+  float samples = 0.0;
+  float wins = 0.0;
+  // decides since this source last won
+  int stale_ticks = 0;
+};
+
+struct SourceBandit {
+  SourceStats stats[N_PARAM_GROUPS][N_SOURCES];
+  int ticks = 0;
+};
+
+// what the next decide samples
+struct Allocation {
+  bool suggestions = true;
+  bool elite = true;
+  // used in place of FULL_CHANGE_PERCENTAGE
+  float full_change_percentage = 0.0;
+  // random sources the bandit tries on this decide, each gets one candidate
+  // before the split so its stats keep moving; none without the bandit
+  bool full_random = false;
+  bool single_random = false;
+};
+
+// group is the param group of the decide, both calls of a decide must get
+// the same one
+Allocation bandit_allocate(const SourceBandit &bandit, int group);
+
+// samples is how many candidates each source got on the last decide
+void bandit_update(SourceBandit &bandit, int group, const int *samples,
+                   DecisionSource winner);
+
+#endif
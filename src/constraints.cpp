@@ -0,0 +1,104 @@
+#include <cmath>
+#include <algorithm>
+
+#include "constraints.h"
+#include "state.h"
+#include "decision.h"
+#include "decision_table.h"
+#include "utils.h"
+
+// how far past the border of a disk a point is pushed
+static constexpr float PROJECTION_MARGIN = 0.001; // 1mm
+static constexpr int PROJECTION_ROUNDS = 16;
+
+static void add_disk(MoveConstraints &c, Vector center, float radius) {
+  c.center[c.count] = center;
+  c.radius[c.count] = radius;
+  c.count++;
+}
+
+void move_constraints_init(MoveConstraints &c, int robot, const State &state,
+                           const DecisionTable &table) {
+  c.count = 0;
+
+  // XXX: do not allow __ANYONE__ (temporary) to enter the defense area
+  if (robot % N_ROBOTS != 0)
+    add_disk(c, GOAL_POS(PLAYER_OF(robot)), DEFENSE_RADIUS);
+
+  add_disk(c, state.ball, ROBOT_RADIUS + BALL_RADIUS);
+
+  FOR_EVERY_ROBOT(i) if (i != robot) {
+    add_disk(c, state.robots[i], 2 * ROBOT_RADIUS);
+  }
+  // the table only has moves for a team, the slots of the enemies are ours
+  FOR_TEAM_ROBOT(i, PLAYER_OF(robot)) if (i != robot) {
+    add_disk(c, table.move[i].move_pos, 2 * ROBOT_RADIUS);
+  }
+}
+
+static bool in_field(Vector pos) {
+  return std::abs(pos.x) <= FIELD_WIDTH / 2 &&
+         std::abs(pos.y) <= FIELD_HEIGHT / 2;
+}
+
+bool move_feasible(const MoveConstraints &c, Vector pos) {
+  if (!in_field(pos))
+    return false;
+  FOR_N(k, c.count) {
+    if (norm2(pos - c.center[k]) <= SQ(c.radius[k]))
+      return false;
+  }
+  return true;
+}
+
+static Vector clamp_to_field(Vector pos) {
+  return {std::min(std::max(pos.x, -FIELD_WIDTH / 2), FIELD_WIDTH / 2),
+          std::min(std::max(pos.y, -FIELD_HEIGHT / 2), FIELD_HEIGHT / 2)};
+}
+
+Vector move_project(const MoveConstraints &c, Vector pos) {
+  FOR_N(round, PROJECTION_ROUNDS) {
+    pos = clamp_to_field(pos);
+
+    bool moved = false;
+    FOR_N(k, c.count) {
+      Vector d = pos - c.center[k];
+      float d2 = norm2(d);
+      if (d2 > SQ(c.radius[k]))
+        continue;
+      // from the center itself, toward the middle of the field
+      if (d2 > 0.0)
+        d = d * (1 / std::sqrt(d2));
+      else if (norm2(c.center[k]) > 0.0)
+        d = (Vector() - c.center[k]) * (1 / norm(c.center[k]));
+      else
+        d = Vector(1, 0);
+      pos = c.center[k] + d * (c.radius[k] + PROJECTION_MARGIN);
+      moved = true;
+    }
+
+    if (!moved)
+      return pos;
+  }
+  // the field is never left, even if that leaves pos in a disk
+  return clamp_to_field(pos);
+}
+
+void project_moves(Decision &decision, Player player, const State &state,
+                   const DecisionTable &table) {
+  DecisionTable moves = table;
+  FOR_TEAM_ROBOT(i, player) {
+    if (decision.action[i].type == MOVE)
+      moves.move[i] = decision.action[i];
+  }
+
+  MoveConstraints c;
+  FOR_TEAM_ROBOT(i, player) {
+    auto &action = decision.action[i];
+    if (action.type != MOVE)
+      continue;
+    move_constraints_init(c, i, state, moves);
+    action.move_pos = move_project(c, action.move_pos);
+    moves.move[i] = action;
+  }
+}
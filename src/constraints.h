@@ -0,0 +1,41 @@
+#ifndef CONSTRAINTS_H
+#define CONSTRAINTS_H
+
+#include "consts.h"
+#include "player.h"
+#include "vector.h"
+#include "state.h"
+
+// the defense area, the ball, the other robots where they are and the others
+// of the team where the table moves them
+constexpr int MAX_MOVE_OBSTACLES = 2 + (2 * N_ROBOTS - 1) + (N_ROBOTS - 1);
+
+// Where a robot may be told to move: inside the field and outside a set of
+// disks, its own defense area (but for the goalkeeper, robot 0), the ball and
+// the other robots. This is what valid_move_pos checks, kept so that many
+// points can be checked or projected for the same robot.
+struct MoveConstraints {
+  int count = 0;
+  Vector center[MAX_MOVE_OBSTACLES];
+  float radius[MAX_MOVE_OBSTACLES];
+};
+
+struct DecisionTable;
+struct Decision;
+
+void move_constraints_init(MoveConstraints &c, int robot, const State &state,
+                           const DecisionTable &table);
+
+bool move_feasible(const MoveConstraints &c, Vector pos);
+
+// a feasible point close to pos: clamped into the field and pushed out of each
+// disk it falls in, for a few rounds since a push may land in another disk;
+// where disks wedge a point in it's left where the last push put it
+Vector move_project(const MoveConstraints &c, Vector pos);
+
+// projects the target of every MOVE action of player, each against the
+// targets of the others as projected so far
+void project_moves(Decision &decision, Player player, const State &state,
+                   const DecisionTable &table);
+
+#endif
@@ -1,6 +1,8 @@
 #define _CONST_IMPL(TYPE, NAME, DEFAULT)                                       \
   TYPE NAME = DEFAULT;                                                         \
   TYPE _V_##NAME[] = {DEFAULT, DEFAULT, DEFAULT, DEFAULT};
+#include <cstring>
+
 #include "consts.h"
 
 int param_group;
@@ -11,44 +13,51 @@ float PARAM_GROUP_THRESHOLD = 1.000;    // 1m
 float PARAM_GROUP_CONQUER_TIME = 0.500; // 0.1s
 
 FineOptimize FINE_OPTIMIZE = OPTIMIZE_BEST;
+int FINE_OPTIMIZE_BUDGET = 8;
+FineMethod FINE_METHOD = FINE_ADAM;
+
+Sampler FULL_RANDOM_SAMPLER = UNIFORM_SAMPLER;
+
+int DECISION_THREADS = 1;
+
+int DECISION_SEED = 0;
+bool LOG_DECISIONS = false;
+
+int MINIMAX_BRANCHING = 8;
+
+bool TRANSPOSITION_TABLE = true;
+float TRANSPOSITION_RESOLUTION = 0.1;
+int TRANSPOSITION_MAX_AGE = 2;
+
+int EVAL_BATCH_SIZE = 8;
+
+bool PRUNE_EVALUATION = true;
+
+bool DELTA_EVALUATION = true;
+
+bool SIMD_SHADOWS = true;
+
+bool GAP_FIELD = false;
+float GAP_FIELD_RESOLUTION = 0.05;
+
+bool ANALYTIC_GRADIENT = true;
+bool DUAL_GRADIENT = true;
+
+bool ADAPTIVE_ALLOCATION = true;
+int SOURCE_STALE_TICKS = 300;
+float SOURCE_DECAY = 0.99;
+float SOURCE_EXPLORATION = 0.01;
+
+bool SYNC_TO_PACKETS = true;
+float PACKET_MARGIN = 0.002;
 
 static void change_param_group(int new_param_group) {
   int oldp = param_group;
   int newp = new_param_group;
-#define PARAM_SWAP(NAME)                                                       \
+#define PARAM_SWAP(TYPE, NAME, DEFAULT)                                        \
   _V_##NAME[oldp] = NAME;                                                      \
   NAME = _V_##NAME[newp];
-  PARAM_SWAP(CONSTANT_RATE);
-  PARAM_SWAP(KICK_IF_NO_PASS);
-  PARAM_SWAP(DECISION_RATE);
-  PARAM_SWAP(RAMIFICATION_NUMBER);
-  PARAM_SWAP(FULL_CHANGE_PERCENTAGE);
-  PARAM_SWAP(MAX_DEPTH);
-  PARAM_SWAP(KICK_POS_VARIATION);
-  PARAM_SWAP(MIN_GAP_TO_KICK);
-  PARAM_SWAP(DESIRED_PASS_DIST);
-  PARAM_SWAP(WEIGHT_BALL_POS);
-  PARAM_SWAP(WEIGHT_MOVE_DIST_MAX);
-  PARAM_SWAP(WEIGHT_MOVE_DIST_TOTAL);
-  PARAM_SWAP(WEIGHT_MOVE_CHANGE);
-  PARAM_SWAP(WEIGHT_PASS_CHANGE);
-  PARAM_SWAP(WEIGHT_KICK_CHANGE);
-  PARAM_SWAP(TOTAL_MAX_GAP_RATIO);
-  PARAM_SWAP(WEIGHT_CLOSE_TO_BALL);
-  PARAM_SWAP(WEIGHT_ENEMY_CLOSE_TO_BALL);
-  PARAM_SWAP(WEIGHT_HAS_BALL);
-  PARAM_SWAP(WEIGHT_ATTACK);
-  PARAM_SWAP(WEIGHT_SEE_ENEMY_GOAL);
-  PARAM_SWAP(WEIGHT_BLOCK_GOAL);
-  PARAM_SWAP(WEIGHT_BLOCK_ATTACKER);
-  PARAM_SWAP(WEIGHT_GOOD_RECEIVERS);
-  PARAM_SWAP(WEIGHT_RECEIVERS_NUM);
-  PARAM_SWAP(WEIGHT_ENEMY_RECEIVERS_NUM);
-  PARAM_SWAP(DIST_GOAL_PENAL);
-  PARAM_SWAP(DIST_GOAL_TO_PENAL);
-  PARAM_SWAP(MOVE_RADIUS_0);
-  PARAM_SWAP(MOVE_RADIUS_1);
-  PARAM_SWAP(MOVE_RADIUS_2);
+  FOR_EVERY_PARAM(PARAM_SWAP)
 #undef PARAM_SWAP
   param_group = new_param_group;
 }
@@ -58,3 +67,19 @@ void set_param_group(int new_param_group) {
   if (param_group != new_param_group)
     change_param_group(new_param_group);
 }
+
+// FNV-1a over the group and the bytes of every PARAM
+uint64_t params_signature() {
+  uint64_t signature = 0xcbf29ce484222325;
+  auto mix = [&signature](const void *value, size_t size) {
+    unsigned char bytes[sizeof(uint64_t)] = {};
+    memcpy(bytes, value, size);
+    for (unsigned char byte : bytes)
+      signature = (signature ^ byte) * 0x100000001b3;
+  };
+  mix(&param_group, sizeof(param_group));
+#define PARAM_MIX(TYPE, NAME, DEFAULT) mix(&NAME, sizeof(NAME));
+  FOR_EVERY_PARAM(PARAM_MIX)
+#undef PARAM_MIX
+  return signature;
+}
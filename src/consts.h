@@ -1,6 +1,8 @@
 #ifndef CONSTS_H
 #define CONSTS_H
 
+#include <stdint.h>
+
 constexpr int N_ROBOTS = 6;
 constexpr int MAX_SUGGESTIONS = 30;
 constexpr int MAX_SUGGESTION_SPOTS = 30;
@@ -42,9 +44,85 @@ extern bool PARAM_GROUP_CONQUER;
 extern float PARAM_GROUP_THRESHOLD;
 extern float PARAM_GROUP_CONQUER_TIME;
 void set_param_group(int new_param_group);
+// changes with the param group and with any PARAM of it
+uint64_t params_signature();
 
-enum FineOptimize { NO_OPTIMIZE, OPTIMIZE_ALL, OPTIMIZE_BEST };
+// OPTIMIZE_TOP_K refines the FINE_TOP_K best distinct candidates in the last
+// FINE_TOP_K_PERCENTAGE of the time of a decide and keeps the best of them
+enum FineOptimize { NO_OPTIMIZE, OPTIMIZE_ALL, OPTIMIZE_BEST, OPTIMIZE_TOP_K };
 extern FineOptimize FINE_OPTIMIZE;
+// evaluations optimize_decision() may spend on each decision, a gradient takes
+// one if ANALYTIC_GRADIENT
+extern int FINE_OPTIMIZE_BUDGET;
+// how optimize_decision() climbs: a line search then adam steps, newton steps
+// on a hessian from differences of the gradient, or bfgs steps
+enum FineMethod { FINE_ADAM, FINE_NEWTON, FINE_BFGS };
+extern FineMethod FINE_METHOD;
+
+// how FULL_RANDOM candidates are drawn: uniformly around each robot or from
+// a distribution refitted to the best candidates so far (cross-entropy)
+enum Sampler { UNIFORM_SAMPLER, CROSS_ENTROPY_SAMPLER };
+extern Sampler FULL_RANDOM_SAMPLER;
+
+// number of threads sampling candidates inside decide()
+constexpr int MAX_DECISION_THREADS = 16;
+extern int DECISION_THREADS;
+
+// seed of the random streams used by decide(), 0 draws a fresh one each time
+extern int DECISION_SEED;
+// print the seed and stats of every decide, to replay one with DECISION_SEED
+// (from the same bandit, elite and decision table, which carry over)
+extern bool LOG_DECISIONS;
+
+// decisions minimax_decide() samples for a player on every ply below the
+// first, see minimax.h
+constexpr int MAX_MINIMAX_BRANCHING = 32;
+extern int MINIMAX_BRANCHING;
+
+// searched states minimax_decide() keeps across ticks, told apart on a grid of
+// TRANSPOSITION_RESOLUTION meters and missed once older than
+// TRANSPOSITION_MAX_AGE searches, see transposition.h
+constexpr int TRANSPOSITION_TABLE_SIZE = 1 << 16;
+extern bool TRANSPOSITION_TABLE;
+extern float TRANSPOSITION_RESOLUTION;
+extern int TRANSPOSITION_MAX_AGE;
+
+// candidates evaluated together by evaluate_batch() inside decide()
+constexpr int MAX_EVAL_BATCH = 16;
+extern int EVAL_BATCH_SIZE;
+
+// stop evaluating candidates that can't be kept by decide()
+extern bool PRUNE_EVALUATION;
+
+// evaluate candidates as changes to the table decision, see delta_eval.h
+extern bool DELTA_EVALUATION;
+
+// compute the shadows on a goal with shadows_from_pos()
+extern bool SIMD_SHADOWS;
+
+// see the enemy goal from a grid of gap values built on every decide, in
+// meters between samples, see gap_field.h
+extern bool GAP_FIELD;
+extern float GAP_FIELD_RESOLUTION;
+
+// fine optimization follows the gradient of gradient.h instead of finite
+// differences
+extern bool ANALYTIC_GRADIENT;
+// without ANALYTIC_GRADIENT, the gradient is differentiated on dual numbers
+// (dual.h) instead of taken from finite differences
+extern bool DUAL_GRADIENT;
+
+// shift candidates toward the decision sources that have been winning,
+// see bandit.h
+extern bool ADAPTIVE_ALLOCATION;
+extern int SOURCE_STALE_TICKS;
+extern float SOURCE_DECAY;
+extern float SOURCE_EXPLORATION;
+
+// with CONSTANT_RATE, size each decide to end PACKET_MARGIN seconds before
+// the next expected packet instead of using DECISION_RATE
+extern bool SYNC_TO_PACKETS;
+extern float PACKET_MARGIN;
 
 #ifdef _CONST_IMPL
 #define PARAM(TYPE, NAME, DEFAULT) _CONST_IMPL(TYPE, NAME, DEFAULT)
@@ -52,37 +130,49 @@ extern FineOptimize FINE_OPTIMIZE;
 #define PARAM(TYPE, NAME, DEFAULT) extern TYPE NAME;
 #endif
 
-PARAM(bool, CONSTANT_RATE, true);
-PARAM(bool, KICK_IF_NO_PASS, false);
-PARAM(int, DECISION_RATE, 7);
-PARAM(int, RAMIFICATION_NUMBER, 5000);
-PARAM(int, FULL_CHANGE_PERCENTAGE, 100);
-PARAM(int, MAX_DEPTH, 0);
-PARAM(float, KICK_POS_VARIATION, 0.150);
-PARAM(float, MIN_GAP_TO_KICK, 18.0);
-PARAM(float, DESIRED_PASS_DIST, 2.0);
-PARAM(float, WEIGHT_BALL_POS, 0);
-PARAM(float, WEIGHT_MOVE_DIST_MAX, 0);
-PARAM(float, WEIGHT_MOVE_DIST_TOTAL, 0);
-PARAM(float, WEIGHT_MOVE_CHANGE, 2);
-PARAM(float, WEIGHT_PASS_CHANGE, 2);
-PARAM(float, WEIGHT_KICK_CHANGE, 2);
-PARAM(float, TOTAL_MAX_GAP_RATIO, 0.5);
-PARAM(float, WEIGHT_CLOSE_TO_BALL, 1000);
-PARAM(float, WEIGHT_ENEMY_CLOSE_TO_BALL, 1000);
-PARAM(float, WEIGHT_HAS_BALL, 5000);
-PARAM(float, WEIGHT_ATTACK, 1000);
-PARAM(float, WEIGHT_SEE_ENEMY_GOAL, 10);
-PARAM(float, WEIGHT_BLOCK_GOAL, 180);
-PARAM(float, WEIGHT_BLOCK_ATTACKER, 5000);
-PARAM(float, WEIGHT_GOOD_RECEIVERS, 0);
-PARAM(float, WEIGHT_RECEIVERS_NUM, 20);
-PARAM(float, WEIGHT_ENEMY_RECEIVERS_NUM, 20);
-PARAM(float, DIST_GOAL_PENAL, 2000);
-PARAM(float, DIST_GOAL_TO_PENAL, 1.0);
-PARAM(float, MOVE_RADIUS_0, 0.5);
-PARAM(float, MOVE_RADIUS_1, 2.0);
-PARAM(float, MOVE_RADIUS_2, 7.0);
+// every PARAM as X(TYPE, NAME, DEFAULT), the one list they are declared,
+// swapped between param groups, signed, saved and loaded from
+#define FOR_EVERY_PARAM(X)                                                     \
+  X(bool, CONSTANT_RATE, true)                                                 \
+  X(bool, KICK_IF_NO_PASS, false)                                              \
+  X(int, DECISION_RATE, 7)                                                     \
+  X(int, RAMIFICATION_NUMBER, 5000)                                            \
+  X(int, FULL_CHANGE_PERCENTAGE, 100)                                          \
+  X(int, MAX_DEPTH, 0)                                                         \
+  X(float, KICK_POS_VARIATION, 0.150)                                          \
+  X(float, MIN_GAP_TO_KICK, 18.0)                                              \
+  X(float, DESIRED_PASS_DIST, 2.0)                                             \
+  X(float, WEIGHT_BALL_POS, 0)                                                 \
+  X(float, WEIGHT_MOVE_DIST_MAX, 0)                                            \
+  X(float, WEIGHT_MOVE_DIST_TOTAL, 0)                                          \
+  X(float, WEIGHT_MOVE_CHANGE, 2)                                              \
+  X(float, WEIGHT_PASS_CHANGE, 2)                                              \
+  X(float, WEIGHT_KICK_CHANGE, 2)                                              \
+  X(float, TOTAL_MAX_GAP_RATIO, 0.5)                                           \
+  X(float, WEIGHT_CLOSE_TO_BALL, 1000)                                         \
+  X(float, WEIGHT_ENEMY_CLOSE_TO_BALL, 1000)                                   \
+  X(float, WEIGHT_HAS_BALL, 5000)                                              \
+  X(float, WEIGHT_ATTACK, 1000)                                                \
+  X(float, WEIGHT_SEE_ENEMY_GOAL, 10)                                          \
+  X(float, WEIGHT_BLOCK_GOAL, 180)                                             \
+  X(float, WEIGHT_BLOCK_ATTACKER, 5000)                                        \
+  X(float, WEIGHT_GOOD_RECEIVERS, 0)                                           \
+  X(float, WEIGHT_RECEIVERS_NUM, 20)                                           \
+  X(float, WEIGHT_ENEMY_RECEIVERS_NUM, 20)                                     \
+  X(float, DIST_GOAL_PENAL, 2000)                                              \
+  X(float, DIST_GOAL_TO_PENAL, 1.0)                                            \
+  X(float, MOVE_RADIUS_0, 0.5)                                                 \
+  X(float, MOVE_RADIUS_1, 2.0)                                                 \
+  X(float, MOVE_RADIUS_2, 7.0)                                                 \
+  X(int, CEM_POPULATION, 64)                                                   \
+  X(int, CEM_ELITE_PERCENTAGE, 10)                                             \
+  X(float, CEM_SMOOTHING, 0.7)                                                 \
+  X(float, CEM_MIN_SIGMA, 0.05)                                                \
+  X(int, ELITE_SIZE, 8)                                                        \
+  X(int, FINE_TOP_K, 4)                                                        \
+  X(int, FINE_TOP_K_PERCENTAGE, 20)
+
+FOR_EVERY_PARAM(PARAM)
 
 enum Weight {
   _WEIGHT_BALL_POS,
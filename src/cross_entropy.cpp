@@ -0,0 +1,124 @@
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include "cross_entropy.h"
+#include "decision_table.h"
+#include "state.h"
+#include "action.h"
+#include "eval_context.h"
+#include "constraints.h"
+#include "utils.h"
+
+// draws rejected before the last one is projected instead
+static constexpr int MAX_TRIES = 8;
+
+static int elite_size() {
+  int size = CEM_POPULATION * CEM_ELITE_PERCENTAGE / 100;
+  return std::min(std::max(size, 1), MAX_CEM_ELITE);
+}
+
+static Action gen_move_action(int robot, const State &state,
+                              DecisionTable &table, const CrossEntropy &cem) {
+  auto mean = cem.mean[robot];
+  auto sigma = cem.sigma[robot];
+
+  MoveConstraints c;
+  move_constraints_init(c, robot, state, table);
+  Vector pos;
+  FOR_N(t, MAX_TRIES) {
+    auto z = normal_rand_vector({});
+    pos = {mean.x + z.x * sigma.x, mean.y + z.y * sigma.y};
+    if (move_feasible(c, pos))
+      return make_move_action(pos);
+  }
+  return make_move_action(move_project(c, pos));
+}
+
+Decision gen_decision(const EvalContext &ctx, DecisionTable &table,
+                      CrossEntropy &cem) {
+  if (!cem.fitted) {
+    cem.rwb = ctx.rwb;
+    return gen_decision(ctx, table);
+  }
+
+  auto &state = *ctx.state;
+  Player player = ctx.player;
+  Decision decision;
+  int rwb = cem.rwb;
+
+  // copy the move table
+  DecisionTable next_table = table;
+
+  FOR_TEAM_ROBOT(i, player) if (i != rwb) {
+    decision.action[i] = gen_move_action(i, state, table, cem);
+    next_table.move[i] = decision.action[i];
+  }
+
+  // push an action for the robot with ball, if it's us
+  if (player == PLAYER_OF(rwb)) {
+    decision.action[rwb] = gen_primary_action(ctx, next_table);
+  }
+
+  return decision;
+}
+
+static void refit(CrossEntropy &cem, Player player) {
+  int n = cem.elite_count;
+  float alpha = cem.fitted ? CEM_SMOOTHING : 1.0;
+
+  FOR_TEAM_ROBOT(i, player) if (i != cem.rwb) {
+    Vector mean = {};
+    FOR_N(k, n) { mean += cem.elite[k][i]; }
+    mean /= n;
+
+    Vector var = {};
+    FOR_N(k, n) {
+      auto d = cem.elite[k][i] - mean;
+      var += Vector(d.x * d.x, d.y * d.y);
+    }
+    var /= n;
+
+    Vector sigma = {std::max(std::sqrt(var.x), CEM_MIN_SIGMA),
+                    std::max(std::sqrt(var.y), CEM_MIN_SIGMA)};
+
+    cem.mean[i] = mean * alpha + cem.mean[i] * (1 - alpha);
+    cem.sigma[i] = sigma * alpha + cem.sigma[i] * (1 - alpha);
+  }
+
+  cem.fitted = true;
+  cem.population = 0;
+  cem.elite_count = 0;
+}
+
+void cem_update(CrossEntropy &cem, const Decision &decision, float value,
+                Player player) {
+  int size = elite_size();
+
+  // insert sorted, dropping the worst when full
+  int k = std::min(cem.elite_count, size - 1);
+  if (cem.elite_count < size || value > cem.elite_value[k]) {
+    while (k > 0 && cem.elite_value[k - 1] < value) {
+      cem.elite_value[k] = cem.elite_value[k - 1];
+      cem.elite[k] = cem.elite[k - 1];
+      k--;
+    }
+    cem.elite_value[k] = value;
+    FOR_TEAM_ROBOT(i, player) {
+      auto action = decision.action[i];
+      cem.elite[k][i] = action.type == MOVE ? action.move_pos : Vector();
+    }
+    cem.elite_count = std::min(cem.elite_count + 1, size);
+  }
+
+  if (++cem.population >= CEM_POPULATION)
+    refit(cem, player);
+}
+
+float cem_threshold(const CrossEntropy &cem, int pending) {
+  int size = elite_size();
+  // the elite is only known to be full until the next refit
+  if (cem.elite_count < size || cem.population + pending >= CEM_POPULATION)
+    return -std::numeric_limits<float>::infinity();
+  return cem.elite_value[size - 1];
+}
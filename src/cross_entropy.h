@@ -0,0 +1,39 @@
+#ifndef CROSS_ENTROPY_H
+#define CROSS_ENTROPY_H
+
+#include "consts.h"
+#include "array.h"
+#include "vector.h"
+#include "player.h"
+#include "decision.h"
+
+constexpr int MAX_CEM_ELITE = 64;
+
+// Cross-entropy sampler for the move targets of a team, it keeps an axis
+// aligned gaussian for each robot and refits it to the best candidates of
+// every generation (CEM_POPULATION evaluated candidates). Until the first
+// generation completes candidates are drawn like gen_decision does.
+struct CrossEntropy {
+  bool fitted = false;
+  int rwb = -1;
+  TeamArray<Vector> mean, sigma;
+
+  // best candidates of the current generation, sorted by value
+  int population = 0;
+  int elite_count = 0;
+  float elite_value[MAX_CEM_ELITE];
+  TeamArray<Vector> elite[MAX_CEM_ELITE];
+};
+
+Decision gen_decision(const struct EvalContext &ctx, DecisionTable &table,
+                      CrossEntropy &cem);
+
+// account for an evaluated candidate, refits when a generation is complete
+void cem_update(CrossEntropy &cem, const Decision &decision, float value,
+                Player player);
+
+// a candidate must be above this value to change the sampler, after pending
+// other updates; -inf when that can't be known
+float cem_threshold(const CrossEntropy &cem, int pending = 0);
+
+#endif
@@ -9,9 +9,10 @@
 #include "utils.h"
 #include "id_table.h"
 #include "segment.h"
+#include "eval_context.h"
 
 void apply_to_state(const Decision decision, Player player,
-                    struct State *state) {
+                    State *state) {
   // apply all moves first
   FOR_TEAM_ROBOT(i, player) {
     if (decision.action[i].type == MOVE)
@@ -24,11 +25,13 @@ void apply_to_state(const Decision decision, Player player,
   }
 }
 
-Decision gen_decision(bool kick, const State &state, Player player,
-                      DecisionTable &table, int robot_to_move) {
+Decision gen_decision(const EvalContext &ctx, DecisionTable &table,
+                      int robot_to_move) {
+  auto &state = *ctx.state;
+  Player player = ctx.player;
   Decision decision;
 
-  int rwb = robot_with_ball(state);
+  int rwb = ctx.rwb;
   int rcv = -1;
 
   // copy the move table
@@ -48,9 +51,8 @@ Decision gen_decision(bool kick, const State &state, Player player,
   }
 
   // push an action for the robot with ball, if it's us
-  if (player == PLAYER_OF(rwb)) {
-    auto action = decision.action[rwb] =
-        gen_primary_action(rwb, state, next_table, kick);
+  if (ctx.has_ball) {
+    auto action = decision.action[rwb] = gen_primary_action(ctx, next_table);
 
     if (action.type == PASS) {
       rcv = action.pass_receiver;
@@ -64,29 +66,30 @@ Decision gen_decision(bool kick, const State &state, Player player,
   return decision;
 }
 
-Decision from_decision_table(DecisionTable &table, const State &state,
-                             Player player, bool kick) {
+Decision from_decision_table(DecisionTable &table, const EvalContext &ctx) {
   Decision decision;
-  int rwb = robot_with_ball(state);
-  if (PLAYER_OF(rwb) != player)
-    rwb = -1;
+  int rwb = ctx.has_ball ? ctx.rwb : -1;
 
   FOR_N(i, N_ROBOTS) { decision.action[i] = table.move[i]; }
 
-  if (kick) {
+  // nothing else to do without the ball
+  if (rwb < 0)
+    return decision;
+
+  if (ctx.kick) {
     if (table.kick_robot >= 0 && table.kick_robot == rwb) {
       decision.action[rwb] = table.kick;
     } else {
-      decision.action[rwb] = gen_kick_action(rwb, state, table);
+      decision.action[rwb] = ctx.kick_action;
     }
   } else {
 #if 1
-    decision.action[rwb] = gen_pass_action(rwb, state, table);
+    decision.action[rwb] = gen_pass_action(ctx, table);
 #else
     if (table.pass_robot >= 0 && table.pass_robot == rwb) {
       decision.action[table.pass_robot] = table.pass;
     } else {
-      decision.action[rwb] = gen_pass_action(rwb, state, table);
+      decision.action[rwb] = gen_pass_action(ctx, table);
     }
 #endif
   }
@@ -94,6 +97,51 @@ Decision from_decision_table(DecisionTable &table, const State &state,
   return decision;
 }
 
+void update_decision_table(DecisionTable &table, const Decision &decision,
+                           Player player) {
+  table.kick_robot = -1;
+  table.pass_robot = -1;
+  FOR_TEAM_ROBOT(i, player) {
+    auto action = decision.action[i];
+    switch (action.type) {
+    case KICK: {
+      table.kick_robot = i;
+      table.kick = action;
+    } break;
+    case PASS: {
+      table.pass_robot = i;
+      table.pass = action;
+    } break;
+    case MOVE: {
+      table.move[i] = action;
+    } break;
+    case NONE:
+      break;
+    }
+  }
+}
+
+Decision from_elite(const Decision &elite, DecisionTable &table,
+                    const EvalContext &ctx) {
+  Decision decision;
+  int rwb = ctx.has_ball ? ctx.rwb : -1;
+
+  // keep the elite moves, robots that had other actions use the table
+  DecisionTable next_table = table;
+  FOR_TEAM_ROBOT(i, ctx.player) if (i != rwb) {
+    auto action = elite.action[i];
+    decision.action[i] = action.type == MOVE ? action : table.move[i];
+    next_table.move[i] = decision.action[i];
+  }
+
+  // the primary action depends too much on the state to be kept
+  if (rwb >= 0) {
+    decision.action[rwb] = gen_primary_action(ctx, next_table);
+  }
+
+  return decision;
+}
+
 void to_proto_action(Action &action, CommandMessage::Action *ptb_action,
                      int robot_id) {
   ptb_action->set_robot_id(robot_id);
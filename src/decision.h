@@ -5,8 +5,8 @@
 #include "action.h"
 #include "array.h"
 #include "player.h"
+#include "state.h"
 
-struct State;
 struct DecisionTable;
 
 struct Decision {
@@ -15,11 +15,18 @@ struct Decision {
 
 void apply_to_state(const Decision decision, Player player, State *state);
 
-Decision gen_decision(bool kick, const State &state, Player player,
-                      DecisionTable &table, int robot_to_move = -1);
+Decision gen_decision(const struct EvalContext &ctx, DecisionTable &table,
+                      int robot_to_move = -1);
 
-Decision from_decision_table(DecisionTable &table, const State &state,
-                             Player player, bool kick);
+Decision from_decision_table(DecisionTable &table, const EvalContext &ctx);
+
+// keeps the actions of decision on the table, as the ones player plans next
+void update_decision_table(DecisionTable &table, const Decision &decision,
+                           Player player);
+
+// reuse the moves of a decision taken on a previous state
+Decision from_elite(const Decision &elite, DecisionTable &table,
+                    const EvalContext &ctx);
 
 void to_proto_command(const Decision &decision, Player player,
                       class CommandMessage &ptb_command,
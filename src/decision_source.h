@@ -5,6 +5,7 @@ enum DecisionSource {
   NO_SOURCE,
   SUGGESTION,
   TABLE,
+  ELITE,
   FULL_RANDOM,
   SINGLE_RANDOM
 };
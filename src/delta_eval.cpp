@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "delta_eval.h"
+#include "eval_context.h"
+#include "optimization.h"
+#include "utils.h"
+
+// with more robots moved than this their shadows are computed in SIMD lanes
+static constexpr int MAX_SCALAR_MOVED = 2;
+
+static int query_of(Player goal_player, int robot) {
+  return robot >= 0 ? robot : 2 * N_ROBOTS + goal_player;
+}
+
+static Vector query_pos(const State &state, int robot) {
+  return robot >= 0 ? state.robots[robot] : state.ball;
+}
+
+static bool same(Vector a, Vector b) { return a.x == b.x && a.y == b.y; }
+
+// keeps shadows sorted by cmp_segments, robots is optional
+static void insert_sorted(Segment *shadows, int *robots, int *count,
+                          Segment shadow, int robot) {
+  int k = (*count)++;
+  for (; k > 0 && cmp_segments(shadow, shadows[k - 1]); k--) {
+    shadows[k] = shadows[k - 1];
+    if (robots)
+      robots[k] = robots[k - 1];
+  }
+  shadows[k] = shadow;
+  if (robots)
+    robots[k] = robot;
+}
+
+static float value_of_sorted(Player goal_player, Vector pos,
+                             const Segment *sorted, int count) {
+  int gaps_count;
+  Segment gaps[2 * N_ROBOTS + 1];
+  std::copy(sorted, sorted + count, gaps);
+  gaps_from_sorted_shadows(gaps, count, &gaps_count);
+  return gap_value_of_gaps(goal_player, pos, gaps, gaps_count);
+}
+
+static void init_gap(GapCache &cache, const State &state, Player goal_player,
+                     Vector pos) {
+  int robots[2 * N_ROBOTS];
+  Segment shadows[2 * N_ROBOTS];
+  float gx = GOAL_X(goal_player);
+  int count = shadows_from_pos(state, pos, gx, shadows, robots);
+
+  cache.pos = pos;
+  cache.has_shadow = {};
+  cache.count = 0;
+  FOR_N(k, count) {
+    cache.has_shadow[robots[k]] = true;
+    insert_sorted(cache.sorted, cache.sorted_robot, &cache.count, shadows[k],
+                  robots[k]);
+  }
+
+  cache.value = value_of_sorted(goal_player, pos, cache.sorted, cache.count);
+}
+
+static int memo_index(Player goal_player, Vector pos) {
+  uint32_t x, y;
+  std::memcpy(&x, &pos.x, sizeof(x));
+  std::memcpy(&y, &pos.y, sizeof(y));
+  uint32_t h = (x * 0x9e3779b1u) ^ (y * 0x85ebca77u) ^ goal_player;
+  return (h ^ (h >> 16)) % GAP_MEMO_SIZE;
+}
+
+// base shadows seen from pos, nullptr the first time pos is queried
+static const GapCache *memo_gap(DeltaEval &delta, Player goal_player,
+                                Vector pos) {
+  auto &memo = delta.memo[memo_index(goal_player, pos)];
+  if (memo.generation != delta.generation ||
+      memo.goal_player != goal_player || !same(memo.cache.pos, pos)) {
+    memo.generation = delta.generation;
+    memo.goal_player = goal_player;
+    memo.ready = false;
+    memo.cache.pos = pos;
+    return nullptr;
+  }
+
+  if (!memo.ready) {
+    init_gap(memo.cache, delta.base, goal_player, pos);
+    memo.ready = true;
+  }
+  return &memo.cache;
+}
+
+static void init_receiver(ReceiverCache &cache, const State &state,
+                          const DecisionTable &table, int i) {
+  Vector move_pos = table.move[i].move_pos;
+  cache.ball_v = unit(move_pos - state.ball) * ROBOT_KICK_SPEED;
+  cache.time =
+      time_to_pos(move_pos, {}, state.ball, cache.ball_v, ROBOT_MAX_SPEED);
+  FOR_EVERY_ROBOT(j) {
+    cache.interceptor_time[j] = time_to_pos(state.robots[j], {}, state.ball,
+                                            cache.ball_v, ROBOT_MAX_SPEED);
+  }
+}
+
+void delta_init(DeltaEval &delta, const EvalContext &ctx,
+                const DecisionTable &table) {
+  delta.table = &table;
+  delta.base = *ctx.state;
+  FOR_TEAM_ROBOT(i, ctx.player) {
+    if (table.move[i].type == MOVE)
+      delta.base.robots[i] = table.move[i].move_pos;
+  }
+
+  FOR_EVERY_ROBOT(i) {
+    init_gap(delta.gaps[i], delta.base, ENEMY_OF(i), delta.base.robots[i]);
+    init_receiver(delta.receivers[i], delta.base, table, i);
+    delta.ball_time[i] =
+        same(delta.base.robots[i], ctx.state->robots[i])
+            ? ctx.ball_time[i]
+            : time_to_pos(delta.base.robots[i], delta.base.robots_v[i],
+                          delta.base.ball, delta.base.ball_v, ROBOT_MAX_SPEED);
+  }
+  FOR_N(p, 2) {
+    init_gap(delta.gaps[query_of((Player)p, -1)], delta.base, (Player)p,
+             delta.base.ball);
+  }
+
+  delta.generation++;
+  delta.next = &delta.base;
+  delta.moved = {};
+  delta.moved_count = 0;
+  delta.ball_moved = false;
+}
+
+void delta_begin(DeltaEval &delta, const State &next) {
+  delta.next = &next;
+  delta.moved_count = 0;
+  FOR_EVERY_ROBOT(i) {
+    delta.moved[i] = !same(next.robots[i], delta.base.robots[i]);
+    delta.moved_count += delta.moved[i];
+  }
+  delta.ball_moved = !same(next.ball, delta.base.ball) ||
+                     !same(next.ball_v, delta.base.ball_v);
+}
+
+// robot queries are always on the goal of the enemy of the robot
+float delta_gap_value(DeltaEval &delta, Player goal_player, int robot) {
+  const GapCache *cache = &delta.gaps[query_of(goal_player, robot)];
+  auto &next = *delta.next;
+  Vector pos = query_pos(next, robot);
+
+  float gx = GOAL_X(goal_player);
+  int count = 0;
+  Segment shadows[2 * N_ROBOTS + 1];
+
+  // a query from somewhere else has no shadow in common with the base, unless
+  // it was memoized from there
+  if (!same(pos, cache->pos)) {
+    cache = memo_gap(delta, goal_player, pos);
+    if (!cache) {
+      int gaps_count;
+      discover_gaps_from_pos(next, pos, goal_player, shadows, &gaps_count);
+      return gap_value_of_gaps(goal_player, pos, shadows, gaps_count);
+    }
+  }
+
+  if (!delta.moved_count)
+    return cache->value;
+
+  // only the robots that moved may cast other shadows
+  int fresh_count = 0;
+  Segment fresh[2 * N_ROBOTS];
+  bool changed = false;
+  if (delta.moved_count > MAX_SCALAR_MOVED) {
+    int robots[2 * N_ROBOTS];
+    int all_count = shadows_from_pos(next, pos, gx, shadows, robots);
+    FOR_N(k, all_count) {
+      if (delta.moved[robots[k]])
+        fresh[fresh_count++] = shadows[k];
+    }
+    changed = fresh_count > 0;
+    FOR_EVERY_ROBOT(i) changed |= delta.moved[i] && cache->has_shadow[i];
+  } else {
+    FOR_EVERY_ROBOT(i) if (delta.moved[i]) {
+      // robots not between pos and the goal line cast no shadow, which is the
+      // case for most of them
+      Vector r = next.robots[i];
+      Segment *shadow = &fresh[fresh_count];
+      bool has_shadow = (r.x - pos.x) * gx > 0 &&
+                        shadow_for_robot_from_pos(r, pos, gx, shadow);
+      changed |= has_shadow || cache->has_shadow[i];
+      if (has_shadow)
+        fresh_count++;
+    }
+  }
+  if (!changed)
+    return cache->value;
+
+  FOR_N(k, cache->count) {
+    if (!delta.moved[cache->sorted_robot[k]])
+      shadows[count++] = cache->sorted[k];
+  }
+  FOR_N(k, fresh_count) {
+    insert_sorted(shadows, nullptr, &count, fresh[k], -1);
+  }
+  return value_of_sorted(goal_player, pos, shadows, count);
+}
+
+// same steps as discover_possible_receivers, only can_receive_pass is cached;
+// if the ball moved nothing is, and both players go through the lanes
+void delta_receivers(const DeltaEval &delta, TeamFilter *results,
+                     const int *passers) {
+  auto &next = *delta.next;
+  auto &table = *delta.table;
+
+  if (delta.ball_moved) {
+    discover_possible_receivers(next, &table, results, passers);
+    return;
+  }
+
+  FOR_N(p, 2) {
+    Player player = (Player)p;
+    auto &result = results[player];
+    int passer = passers[player];
+
+    FOR_TEAM_ROBOT_IN(i, player, result) {
+      Vector move_pos = table.move[i].move_pos;
+
+      // filter out too far locations
+      if (norm2(move_pos - next.ball) > SQ(MAX_PASS_DISTANCE)) {
+        filter_out(result, i);
+        continue;
+      }
+
+      // check if the receiver can get there before the ball
+      float robot_to_pos_time =
+          norm2(move_pos - next.robots[i]) / SQ(ROBOT_MAX_SPEED);
+      float ball_to_pos_time =
+          norm2(move_pos - next.ball) / SQ(ROBOT_KICK_SPEED);
+      float passer_to_ball_time =
+          passer >= 0
+              ? norm2(next.robots[passer] - next.ball) / SQ(ROBOT_MAX_SPEED)
+              : 0.0;
+      if (passer_to_ball_time + ball_to_pos_time < robot_to_pos_time) {
+        filter_out(result, i);
+        continue;
+      }
+
+      // can_receive_pass
+      auto &cache = delta.receivers[i];
+      int vrobot = i;
+      float min_time = cache.time;
+      FOR_TEAM_ROBOT(j, ENEMY_OF(player)) {
+        float t = !delta.moved[j]
+                      ? cache.interceptor_time[j]
+                      : time_to_pos(next.robots[j], {}, next.ball,
+                                    cache.ball_v, ROBOT_MAX_SPEED);
+        if (t < min_time) {
+          vrobot = j;
+          min_time = t;
+        }
+      }
+
+      if (vrobot != i)
+        filter_out(result, i);
+    }
+  }
+}
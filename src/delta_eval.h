@@ -0,0 +1,87 @@
+#ifndef DELTA_EVAL_H
+#define DELTA_EVAL_H
+
+#include "consts.h"
+#include "state.h"
+#include "player.h"
+#include "segment.h"
+#include "filter.h"
+#include "decision_table.h"
+
+// Incremental evaluation of candidates against a base state, the one where
+// every robot of the player goes to its decision table move. For every gap
+// query (a robot or the ball looking at a goal) the sorted shadows are kept,
+// and for every pass receiver the time each interceptor takes to the ball.
+// A candidate only recomputes the entries of the robots it moved, and
+// everything that depends on the ball if it moved the ball; a query none of
+// the moved robots casts a shadow on is not recomputed at all. Values are the
+// same as gap_value and discover_possible_receivers on the candidate state.
+// Queries from a position the base doesn't have, like a robot that moved or
+// the ball after a pass, are kept in a small memo once seen twice, with the
+// shadows of the base from there: the enemy never moves in a candidate, so
+// only our moved robots are merged in when that position comes again.
+// The time every robot takes to the ball is kept too, for robot_with_ball on
+// candidates that leave the ball where it is.
+
+struct GapCache {
+  Vector pos;
+  GameArray<bool> has_shadow;
+  // the shadows sorted by cmp_segments and the robot casting each
+  int count;
+  Segment sorted[2 * N_ROBOTS];
+  int sorted_robot[2 * N_ROBOTS];
+  float value;
+};
+
+constexpr int GAP_MEMO_SIZE = 64;
+
+struct GapMemo {
+  int generation = -1;
+  Player goal_player;
+  // the cache is only filled on the second query from pos
+  bool ready;
+  GapCache cache;
+};
+
+struct ReceiverCache {
+  // pass from the ball to the table move of the receiver
+  Vector ball_v;
+  float time;
+  GameArray<float> interceptor_time;
+};
+
+struct DeltaEval {
+  const DecisionTable *table = nullptr;
+  State base;
+  // a query for each robot and one from the ball for each goal
+  GapCache gaps[2 * N_ROBOTS + 2];
+  ReceiverCache receivers[2 * N_ROBOTS];
+  // time_to_pos of every robot to the ball, as robot_with_ball computes it
+  GameArray<float> ball_time;
+  GapMemo memo[GAP_MEMO_SIZE];
+  // memo entries of other generations belong to an older base
+  int generation = 0;
+
+  // candidate being evaluated
+  const State *next = nullptr;
+  GameArray<bool> moved;
+  int moved_count = 0;
+  bool ball_moved = false;
+};
+
+// ctx is of the state the base comes from, the times of the robots the table
+// leaves where they are are taken from it
+void delta_init(DeltaEval &delta, const struct EvalContext &ctx,
+                const DecisionTable &table);
+
+// next must stay alive while the candidate is evaluated
+void delta_begin(DeltaEval &delta, const State &next);
+
+// gap_value on the goal of goal_player, from robot or from the ball if -1
+float delta_gap_value(DeltaEval &delta, Player goal_player, int robot);
+
+// discover_possible_receivers for both players, indexed by Player
+void delta_receivers(const DeltaEval &delta, TeamFilter *results,
+                     const int *passers);
+
+#endif
@@ -379,7 +379,7 @@ void draw_state(const State &state) {
   draw_ball(state.ball);
 }
 
-void draw_decision(const struct Decision &decision, const struct State &state,
+void draw_decision(const struct Decision &decision, const State &state,
                    Player player) {
   FOR_TEAM_ROBOT(i, player) {
     auto action = decision.action[i % N_ROBOTS];
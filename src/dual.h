@@ -0,0 +1,75 @@
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <cmath>
+
+// forward automatic differentiation: a value with its derivative along one
+// direction, carried through the arithmetic by the chain rule. Comparisons
+// only look at the value, so branches are those of the float computation.
+struct Dual {
+  float val, der;
+
+  constexpr Dual(float val = 0, float der = 0) : val(val), der(der) {}
+
+  Dual &operator+=(Dual o) {
+    val += o.val;
+    der += o.der;
+    return *this;
+  }
+  Dual &operator-=(Dual o) {
+    val -= o.val;
+    der -= o.der;
+    return *this;
+  }
+  Dual &operator*=(Dual o) {
+    der = der * o.val + val * o.der;
+    val *= o.val;
+    return *this;
+  }
+  Dual &operator/=(Dual o) {
+    der = (der * o.val - val * o.der) / (o.val * o.val);
+    val /= o.val;
+    return *this;
+  }
+};
+
+inline Dual operator+(Dual a, Dual b) { return a += b; }
+inline Dual operator-(Dual a, Dual b) { return a -= b; }
+inline Dual operator*(Dual a, Dual b) { return a *= b; }
+inline Dual operator/(Dual a, Dual b) { return a /= b; }
+inline Dual operator-(Dual a) { return Dual(-a.val, -a.der); }
+
+inline bool operator<(Dual a, Dual b) { return a.val < b.val; }
+inline bool operator>(Dual a, Dual b) { return a.val > b.val; }
+inline bool operator<=(Dual a, Dual b) { return a.val <= b.val; }
+inline bool operator>=(Dual a, Dual b) { return a.val >= b.val; }
+inline bool operator==(Dual a, Dual b) { return a.val == b.val; }
+inline bool operator!=(Dual a, Dual b) { return a.val != b.val; }
+
+// also for the derivatives of sqrt at zero, zero lengths don't move
+inline Dual sqrt(Dual a) {
+  float s = std::sqrt(a.val);
+  return Dual(s, a.der == 0 ? 0 : a.der / (2 * s));
+}
+
+inline Dual fabs(Dual a) { return a.val < 0 ? -a : a; }
+
+inline Dual fmin(Dual a, Dual b) { return b < a ? b : a; }
+
+// a constant stays constant even at the ends, where acos has no derivative
+inline Dual acos(Dual a) {
+  float der = a.der == 0 ? 0 : -a.der / std::sqrt(1 - a.val * a.val);
+  return Dual(std::acos(a.val), der);
+}
+
+inline Dual atan2(Dual y, Dual x) {
+  float r2 = x.val * x.val + y.val * y.val;
+  return Dual(std::atan2(y.val, x.val), (x.val * y.der - y.val * x.der) / r2);
+}
+
+// the float a value stands for, so code templated on the scalar can hand it to
+// float only code
+inline float value_of(float a) { return a; }
+inline float value_of(Dual a) { return a.val; }
+
+#endif
@@ -0,0 +1,71 @@
+#include <limits>
+#include <algorithm>
+
+#include "elite.h"
+#include "utils.h"
+
+static bool similar(const Decision &a, const Decision &b, Player player) {
+  FOR_TEAM_ROBOT(i, player) {
+    auto aa = a.action[i];
+    auto ba = b.action[i];
+    if (aa.type != ba.type)
+      return false;
+    switch (aa.type) {
+    case MOVE:
+      if (norm2(aa.move_pos - ba.move_pos) > SQ(ROBOT_RADIUS))
+        return false;
+      break;
+    case KICK:
+      if (norm2(aa.kick_pos - ba.kick_pos) > SQ(ROBOT_RADIUS))
+        return false;
+      break;
+    case PASS:
+      if (aa.pass_receiver != ba.pass_receiver)
+        return false;
+      break;
+    case NONE:
+      break;
+    }
+  }
+  return true;
+}
+
+bool elite_insert(ElitePool &pool, const ValuedDecision &vd, int size,
+                  Player player) {
+  size = std::min(size, MAX_ELITE);
+  pool.count = std::min(pool.count, std::max(size, 0));
+  if (size <= 0 || vd.value <= elite_threshold(pool, size))
+    return false;
+
+  // a near duplicate is replaced if this one is better
+  FOR_N(k, pool.count) {
+    if (similar(pool.entries[k].decision, vd.decision, player)) {
+      if (vd.value <= pool.entries[k].value)
+        return false;
+      FOR_RANGE(j, k, pool.count - 1) { pool.entries[j] = pool.entries[j + 1]; }
+      pool.count--;
+      break;
+    }
+  }
+
+  // insert sorted, dropping the worst when full
+  int k = std::min(pool.count, size - 1);
+  while (k > 0 && pool.entries[k - 1].value < vd.value) {
+    pool.entries[k] = pool.entries[k - 1];
+    k--;
+  }
+  pool.entries[k] = vd;
+  pool.count = std::min(pool.count + 1, size);
+  return true;
+}
+
+void elite_merge(ElitePool &pool, const ElitePool &other, int size,
+                 Player player) {
+  FOR_N(k, other.count) { elite_insert(pool, other.entries[k], size, player); }
+}
+
+float elite_threshold(const ElitePool &pool, int size) {
+  if (pool.count < std::min(size, MAX_ELITE))
+    return -std::numeric_limits<float>::infinity();
+  return pool.entries[pool.count - 1].value;
+}
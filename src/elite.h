@@ -0,0 +1,29 @@
+#ifndef ELITE_H
+#define ELITE_H
+
+#include "consts.h"
+#include "player.h"
+#include "valued_decision.h"
+
+constexpr int MAX_ELITE = 32;
+
+// Bounded set of the best distinct decisions, sorted by value (best first).
+// Two decisions are near duplicates when they have the same action types and
+// receivers and no move target differs by more than a robot radius, of those
+// only the best is kept.
+struct ElitePool {
+  int count = 0;
+  ValuedDecision entries[MAX_ELITE];
+};
+
+// returns whether the decision was kept, the pool holds at most size entries
+bool elite_insert(ElitePool &pool, const ValuedDecision &vd, int size,
+                  Player player);
+
+void elite_merge(ElitePool &pool, const ElitePool &other, int size,
+                 Player player);
+
+// a decision must be above this value to enter the pool
+float elite_threshold(const ElitePool &pool, int size);
+
+#endif
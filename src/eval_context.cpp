@@ -0,0 +1,29 @@
+#include "eval_context.h"
+#include "utils.h"
+
+void eval_context_init(EvalContext &ctx, const State &state, Player player) {
+  ctx.state = &state;
+  ctx.player = player;
+  ctx.rwb = robot_with_ball(state, &ctx.time_min, &ctx.time_max,
+                            &ctx.rwb_min, &ctx.rwb_max);
+  FOR_EVERY_ROBOT(i) {
+    ctx.ball_time[i] = time_to_pos(state.robots[i], state.robots_v[i],
+                                   state.ball, state.ball_v);
+  }
+
+  ctx.has_ball = PLAYER_OF(ctx.rwb) == player;
+
+  ctx.kick_gaps_count = 0;
+  ctx.kick = false;
+  ctx.kick_action = Action();
+  if (!ctx.has_ball)
+    return;
+
+  Player enemy = ENEMY_FOR(player);
+  discover_gaps_from_pos(state, state.ball, enemy, ctx.kick_gaps,
+                         &ctx.kick_gaps_count, ctx.rwb);
+  ctx.kick =
+      can_kick_from_gaps(state, player, ctx.kick_gaps, ctx.kick_gaps_count);
+  ctx.kick_action =
+      kick_action_of_gaps(enemy, ctx.kick_gaps, ctx.kick_gaps_count);
+}
@@ -0,0 +1,41 @@
+#ifndef EVAL_CONTEXT_H
+#define EVAL_CONTEXT_H
+
+#include "consts.h"
+#include "array.h"
+#include "player.h"
+#include "segment.h"
+#include "action.h"
+#include "state.h"
+
+// What the candidates of a decide derive from its state alone, built once
+// before searching and only read by the workers: who has the ball and how
+// long every robot takes to it, and, when the ball is ours, the gaps on the
+// enemy goal that decide if we kick and where. The shadows seen from each
+// robot and the pass interceptions depend on where the decision table moves
+// our robots, so they are kept by DeltaEval (delta_eval.h) instead, which
+// takes the ball times of the robots the table doesn't move from here.
+
+struct EvalContext {
+  const State *state = nullptr;
+  Player player = MIN;
+  // robot_with_ball of the state and the best of each player
+  int rwb = -1, rwb_min = -1, rwb_max = -1;
+  float time_min = 0, time_max = 0;
+  // whether rwb is a robot of player
+  bool has_ball = false;
+  // time_to_pos of every robot to the ball, as robot_with_ball computes it
+  GameArray<float> ball_time;
+  // gaps on the enemy goal seen from the ball without the shadow of rwb, only
+  // if rwb is ours
+  int kick_gaps_count = 0;
+  Segment kick_gaps[2 * N_ROBOTS];
+  // can_kick_directly and gen_kick_action for rwb
+  bool kick = false;
+  Action kick_action;
+};
+
+// state must stay alive while the context is used
+void eval_context_init(EvalContext &ctx, const State &state, Player player);
+
+#endif
@@ -0,0 +1,54 @@
+#include <cmath>
+#include <algorithm>
+
+#include "gap_field.h"
+#include "optimization.h"
+#include "utils.h"
+
+void gap_field_resize(GapField &field, Player goal_player, float resolution) {
+  field.goal_player = goal_player;
+  // a zero or negative resolution would ask for endless samples
+  field.resolution = std::max(resolution, 0.01f);
+  field.cols = (int)std::ceil(FIELD_WIDTH / field.resolution) + 1;
+  field.rows = (int)std::ceil(FIELD_HEIGHT / field.resolution) + 1;
+  field.values.resize(field.cols * field.rows);
+}
+
+void gap_field_fill(GapField &field, const State &state, int part, int parts) {
+  Player goal_player = field.goal_player;
+  float gx = GOAL_X(goal_player);
+  State obstacles = state;
+
+  for (int r = part; r < field.rows; r += parts) {
+    FOR_N(c, field.cols) {
+      Vector pos = {-FIELD_WIDTH / 2 + c * field.resolution,
+                    -FIELD_HEIGHT / 2 + r * field.resolution};
+
+      // a robot on the query position casts no shadow
+      FOR_TEAM_ROBOT(i, ENEMY_FOR(goal_player)) { obstacles.robots[i] = pos; }
+
+      int gaps_count;
+      Segment gaps[2 * N_ROBOTS + 1];
+      int shadows_count = shadows_from_pos(obstacles, pos, gx, gaps);
+      gaps_from_shadows(gaps, shadows_count, &gaps_count);
+      field.values[r * field.cols + c] =
+          gap_value_of_gaps(goal_player, pos, gaps, gaps_count);
+    }
+  }
+}
+
+float gap_field_lookup(const GapField &field, Vector pos) {
+  float x = (pos.x + FIELD_WIDTH / 2) / field.resolution;
+  float y = (pos.y + FIELD_HEIGHT / 2) / field.resolution;
+  x = std::min(std::max(x, 0.0f), field.cols - 1.0f);
+  y = std::min(std::max(y, 0.0f), field.rows - 1.0f);
+
+  int c = std::min((int)x, field.cols - 2);
+  int r = std::min((int)y, field.rows - 2);
+  float fx = x - c, fy = y - r;
+
+  const float *v = &field.values[r * field.cols + c];
+  float bottom = v[0] + fx * (v[1] - v[0]);
+  float top = v[field.cols] + fx * (v[field.cols + 1] - v[field.cols]);
+  return bottom + fy * (top - bottom);
+}
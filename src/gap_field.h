@@ -0,0 +1,33 @@
+#ifndef GAP_FIELD_H
+#define GAP_FIELD_H
+
+#include <vector>
+
+#include "state.h"
+#include "player.h"
+#include "vector.h"
+
+// gap_value on the goal of goal_player sampled on a grid over the field, with
+// only the robots of goal_player casting shadows: those are the ones a
+// candidate of the other player never moves. Lookups interpolate the four
+// nearest samples, so a query costs the same wherever it is.
+
+struct GapField {
+  Player goal_player = MIN;
+  float resolution = 0;
+  // samples along x and y, the first one on the corner of the field
+  int cols = 0, rows = 0;
+  // row major, rows * cols
+  std::vector<float> values;
+};
+
+// sizes the grid, every sample must then be written by gap_field_fill
+void gap_field_resize(GapField &field, Player goal_player, float resolution);
+
+// fills every parts-th row starting at part, parts can fill concurrently
+void gap_field_fill(GapField &field, const State &state, int part, int parts);
+
+// bilinear lookup, positions off the field are moved to its border
+float gap_field_lookup(const GapField &field, Vector pos);
+
+#endif
@@ -0,0 +1,348 @@
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "gradient.h"
+#include "state.h"
+#include "decision.h"
+#include "decision_table.h"
+#include "filter.h"
+#include "optimization.h"
+#include "utils.h"
+
+// width of the soft minimum over times to the ball, in seconds
+static constexpr float TIME_SMOOTHING = 0.01;
+
+// a gap limit, either a goal post or an edge of the shadow of robot
+struct Edge {
+  float y;
+  int robot = -1;
+  Vector d_robot, d_pos;
+};
+
+struct EdgeSegment {
+  Edge u, d;
+};
+
+// gap_value at pos and its derivatives to pos and to every robot, the gaps
+// are found with the same steps as discover_gaps_from_pos and
+// gaps_from_sorted_shadows, keeping where each limit comes from
+static float gap_value_gradient(const State &state, Player goal_player,
+                                Vector pos, Vector *d_pos,
+                                GameArray<Vector> *d_robots) {
+  float gx = GOAL_X(goal_player);
+
+  int count = 0;
+  EdgeSegment shadows[2 * N_ROBOTS];
+  FOR_EVERY_ROBOT(i) {
+    Vector r = state.robots[i];
+    Segment s;
+    if (!shadow_for_robot_from_pos(r, pos, gx, &s))
+      continue;
+
+    ShadowGradient g;
+    shadow_gradient(r, pos, gx, &g);
+    EdgeSegment shadow;
+    shadow.u.y = s.u;
+    shadow.u.robot = i;
+    shadow.u.d_robot = g.du_rpos;
+    shadow.u.d_pos = g.du_pos;
+    shadow.d.y = s.d;
+    shadow.d.robot = i;
+    shadow.d.d_robot = g.dd_rpos;
+    shadow.d.d_pos = g.dd_pos;
+
+    // sorted by cmp_segments
+    int k = count++;
+    for (; k > 0 && cmp_segments(s, {shadows[k - 1].u.y, shadows[k - 1].d.y});
+         k--)
+      shadows[k] = shadows[k - 1];
+    shadows[k] = shadow;
+  }
+
+  // merge shadows so no shadow overlap
+  int merged_count = 0;
+  if (count > 0) {
+    EdgeSegment current = shadows[0];
+    FOR_RANGE(k, 1, count) {
+      auto &shadow = shadows[k];
+      if (shadow.d.y >= current.d.y)
+        continue;
+      if (shadow.u.y >= current.d.y) {
+        current.d = shadow.d;
+      } else {
+        shadows[merged_count++] = current;
+        current = shadow;
+      }
+    }
+    shadows[merged_count++] = current;
+  }
+
+  // gather gaps on the goal from merged shadows
+  EdgeSegment gaps[2 * N_ROBOTS + 1];
+  EdgeSegment current_gap;
+  current_gap.u.y = GOAL_WIDTH / 2;
+  current_gap.d.y = -GOAL_WIDTH / 2;
+  int gaps_count = 0;
+  bool has_last = true;
+  FOR_N(k, merged_count) {
+    auto &shadow = shadows[k];
+    if (shadow.u.y < current_gap.u.y)
+      gaps[gaps_count++] = {current_gap.u, shadow.u};
+    if (shadow.d.y <= current_gap.d.y) {
+      has_last = false;
+      break;
+    }
+    current_gap.u = shadow.d;
+  }
+  if (has_last)
+    gaps[gaps_count++] = current_gap;
+
+  // the value, as gap_value_of_gaps computes it
+  Segment plain[2 * N_ROBOTS + 1];
+  float total_linear = 0.0, max_linear = 0.0;
+  int max_k = -1;
+  FOR_N(k, gaps_count) {
+    plain[k] = {gaps[k].u.y, gaps[k].d.y};
+    float len = plain[k].u - plain[k].d;
+    total_linear += len;
+    if (len > max_linear) {
+      max_linear = len;
+      max_k = k;
+    }
+  }
+  float value = gap_value_of_gaps(goal_player, pos, plain, gaps_count);
+
+  // d/dl and d/dd of the angle 2.atan2(l / 2, d), in degrees
+  Vector to_goal = pos - GOAL_POS(goal_player);
+  float dist_to_goal = norm(to_goal);
+  auto d_len = [&](float len) {
+    return DEGREES(dist_to_goal / (SQ(dist_to_goal) + SQ(len) / 4));
+  };
+  auto d_dist = [&](float len) {
+    return DEGREES(-len / (SQ(dist_to_goal) + SQ(len) / 4));
+  };
+  float r = TOTAL_MAX_GAP_RATIO;
+
+  auto add_edge = [&](const Edge &edge, float c) {
+    if (edge.robot < 0)
+      return;
+    (*d_robots)[edge.robot] += edge.d_robot * c;
+    *d_pos += edge.d_pos * c;
+  };
+  FOR_N(k, gaps_count) {
+    float c = r * d_len(total_linear);
+    if (k == max_k)
+      c += (1 - r) * d_len(max_linear);
+    add_edge(gaps[k].u, c);
+    add_edge(gaps[k].d, -c);
+  }
+  if (dist_to_goal > 0) {
+    float c = r * d_dist(total_linear) + (1 - r) * d_dist(max_linear);
+    *d_pos += to_goal * (c / dist_to_goal);
+  }
+
+  return value;
+}
+
+// derivatives of the time each robot of player takes to the ball, weighted
+// for a soft minimum of them scaled by c, added to g and g_ball
+static void add_time_gradient(const State &next, Player player, float c,
+                              GameArray<Vector> &g, Vector &g_ball) {
+  constexpr float unreachable = std::numeric_limits<float>::max();
+  GameArray<float> t;
+  float t_min = unreachable;
+  FOR_TEAM_ROBOT(i, player) {
+    t[i] = time_to_pos(next.robots[i], next.robots_v[i], next.ball,
+                       next.ball_v);
+    t_min = std::min(t_min, t[i]);
+  }
+  if (t_min == unreachable)
+    return;
+
+  GameArray<float> w;
+  float w_total = 0;
+  FOR_TEAM_ROBOT(i, player) {
+    w[i] = t[i] == unreachable ? 0 : std::exp((t_min - t[i]) / TIME_SMOOTHING);
+    w_total += w[i];
+  }
+  FOR_TEAM_ROBOT(i, player) {
+    if (w[i] == 0)
+      continue;
+    Vector dt = time_to_pos_gradient(next.robots[i], next.ball, next.ball_v) *
+                (c * w[i] / w_total);
+    g[i] += dt;
+    g_ball = g_ball - dt;
+  }
+}
+
+// derivative of the terms computed on the moved state, to the position of
+// every robot and of the ball on it
+static void state_gradient(Player player, const State &next,
+                           const DecisionTable &table, GameArray<Vector> &g,
+                           Vector &g_ball) {
+  Player enemy = ENEMY_FOR(player);
+
+  // close_to_ball, enemy_close_to_ball and has_ball, the last one as a
+  // logistic of how much sooner we get to the ball
+  float time_min, time_max;
+  int rwb_min, rwb_max;
+  int rwb = robot_with_ball(next, &time_min, &time_max, &rwb_min, &rwb_max);
+  float time_player = player == MAX ? time_max : time_min;
+  float time_enemy = player == MIN ? time_max : time_min;
+  float lead = std::exp((time_player - time_enemy) / TIME_SMOOTHING);
+  float owning = std::isfinite(lead) ? lead / SQ(1 + lead) / TIME_SMOOTHING : 0;
+  add_time_gradient(next, player,
+                    -WEIGHT_CLOSE_TO_BALL / SQ(1 + time_player) -
+                        WEIGHT_HAS_BALL * owning,
+                    g, g_ball);
+  add_time_gradient(next, enemy,
+                    WEIGHT_ENEMY_CLOSE_TO_BALL / SQ(1 + time_enemy) +
+                        WEIGHT_HAS_BALL * owning,
+                    g, g_ball);
+
+  g_ball.x += WEIGHT_BALL_POS;
+
+  auto add_gap = [&](float weight, Player goal_player, Vector pos,
+                     Vector *g_pos) {
+    GameArray<Vector> d_robots;
+    Vector d_pos;
+    gap_value_gradient(next, goal_player, pos, &d_pos, &d_robots);
+    FOR_EVERY_ROBOT(j) { g[j] += d_robots[j] * weight; }
+    *g_pos += d_pos * weight;
+  };
+
+  add_gap(WEIGHT_ATTACK, enemy, next.ball, &g_ball);
+  add_gap(-WEIGHT_BLOCK_ATTACKER, player, next.ball, &g_ball);
+  FOR_TEAM_ROBOT(i, enemy) {
+    add_gap(-WEIGHT_BLOCK_GOAL, player, next.robots[i], &g[i]);
+  }
+
+  // see_enemy_goal, the derivatives of each are kept for good_receivers
+  TeamArray<float> gap;
+  GameArray<Vector> d_gap_robots[N_ROBOTS];
+  TeamArray<Vector> d_gap_pos;
+  FOR_TEAM_ROBOT(i, player) {
+    auto &d_robots = d_gap_robots[i % N_ROBOTS];
+    Vector d_pos;
+    gap[i] = gap_value_gradient(next, enemy, next.robots[i], &d_pos, &d_robots);
+    d_gap_pos[i] = d_pos;
+    FOR_EVERY_ROBOT(j) { g[j] += d_robots[j] * WEIGHT_SEE_ENEMY_GOAL; }
+    g[i] += d_pos * WEIGHT_SEE_ENEMY_GOAL;
+  }
+
+  // good_receivers, from the best of them
+  if (WEIGHT_GOOD_RECEIVERS == 0)
+    return;
+
+  bool has_ball = PLAYER_OF(rwb) == player;
+  TeamFilter receivers;
+  discover_possible_receivers(next, &table, player, receivers,
+                              has_ball ? rwb : -1);
+  int rwb_player = player == MAX ? rwb_max : rwb_min;
+
+  int best = -1;
+  float best_receiver = 0;
+  FOR_TEAM_ROBOT(i, player) {
+    auto robot = next.robots[i];
+    if (rwb_player != i && !receivers[i] &&
+        norm2(robot - GOAL_POS(enemy)) > SQ(DEFENSE_RADIUS)) {
+      float this_gap = fmin(0.1, gap[i]);
+      float good_receiver =
+          this_gap / (1 + SQ(DESIRED_PASS_DIST - norm(next.ball - robot)));
+      good_receiver += robot.x + FIELD_WIDTH / 2;
+      if (best_receiver < good_receiver) {
+        best_receiver = good_receiver;
+        best = i;
+      }
+    }
+  }
+  if (best < 0)
+    return;
+
+  auto robot = next.robots[best];
+  float this_gap = fmin(0.1, gap[best]);
+  float ball_dist = norm(next.ball - robot);
+  float q = DESIRED_PASS_DIST - ball_dist;
+  float w = WEIGHT_GOOD_RECEIVERS;
+
+  if (gap[best] < 0.1) {
+    float c = w / (1 + SQ(q));
+    FOR_EVERY_ROBOT(j) { g[j] += d_gap_robots[best % N_ROBOTS][j] * c; }
+    g[best] += d_gap_pos[best] * c;
+  }
+  if (ball_dist > 0) {
+    // q goes down as the robot gets away from the ball
+    Vector away = (robot - next.ball) / ball_dist;
+    float c = w * this_gap * -2 * q / SQ(1 + SQ(q));
+    g[best] += away * -c;
+    g_ball += away * c;
+  }
+  g[best].x += w;
+}
+
+Gradient analytic_gradient(Player player, const State &state,
+                           const Decision &decision,
+                           const DecisionTable &table) {
+  State next = state;
+  apply_to_state(decision, player, &next);
+
+  GameArray<Vector> g;
+  Vector g_ball;
+  state_gradient(player, next, table, g, g_ball);
+
+  Gradient grad;
+  float move_dist_max = 0;
+  int move_max = -1;
+  FOR_TEAM_ROBOT(i, player) {
+    auto action = decision.action[i];
+    if (action.type != MOVE)
+      continue;
+    grad.deltas[i] = g[i];
+
+    // move_dist_total and move_dist_max
+    auto nvec = action.move_pos - state.robots[i];
+    float move_dist = norm(nvec);
+    if (move_dist > 0)
+      grad.deltas[i] += nvec * (-WEIGHT_MOVE_DIST_TOTAL / move_dist);
+    if (move_dist > move_dist_max) {
+      move_dist_max = move_dist;
+      move_max = i;
+    }
+    // move_change never differs from 0, see combine()
+  }
+  if (move_max >= 0) {
+    auto nvec = decision.action[move_max].move_pos - state.robots[move_max];
+    grad.deltas[move_max] += nvec * (-WEIGHT_MOVE_DIST_MAX / move_dist_max);
+  }
+
+  FOR_TEAM_ROBOT(i, player) {
+    auto action = decision.action[i];
+    if (action.type != PASS)
+      continue;
+    int rcv = action.pass_receiver;
+    if (decision.action[rcv].type != MOVE)
+      continue;
+
+    // pass_change
+    if (table.pass_robot >= 0) {
+      auto v = decision.action[rcv].move_pos -
+               table.move[table.pass.pass_receiver].move_pos;
+      float len = norm(v);
+      if (len > 0)
+        grad.deltas[rcv] += v * (-WEIGHT_PASS_CHANGE / len);
+    }
+
+    // the ball stops short of the receiver, on the line from where it was
+    auto v = decision.action[rcv].move_pos - state.ball;
+    float len = norm(v);
+    if (len > 0) {
+      Vector u = v / len;
+      float k = (ROBOT_RADIUS + BALL_RADIUS) / len;
+      Vector across = g_ball - u * (u * g_ball);
+      grad.deltas[rcv] += g_ball - across * k;
+    }
+  }
+
+  return grad;
+}
@@ -1,8 +1,28 @@
 #ifndef GRADIENT_H
 #define GRADIENT_H
 
+#include "array.h"
+#include "vector.h"
+#include "player.h"
+#include "state.h"
+
 struct Gradient {
   TeamArray<Vector> deltas = {};
 };
 
+struct Decision;
+struct DecisionTable;
+
+// Derivative of evaluate_with_decision to the move_pos of every robot with a
+// MOVE action, in a single pass over the terms. Which robots cast each shadow,
+// which receivers there are and who is closest to the ball are taken as they
+// are on the moved state; the terms that jump with the last one are smoothed
+// over TIME_SMOOTHING seconds so they still pull robots toward the ball.
+// Receiver counts and the penalty near the enemy goal are steps and give
+// nothing. With the ball passed to a robot that moves, its move also moves
+// the ball.
+Gradient analytic_gradient(Player player, const State &state,
+                           const Decision &decision,
+                           const DecisionTable &table);
+
 #endif
@@ -21,6 +21,7 @@
 #include "app.h"
 #include "utils.h"
 #include "suggestions.h"
+#include "elite.h"
 
 static GLFWwindow *window;
 static bool mouse_pressed[3] = {false, false, false};
@@ -623,8 +624,53 @@ void gui_render(void) {
                  PARAM_GROUP_CONQUER ? 4 : 2);
     set_param_group(_PARAM_GROUP);
   }
-  const char *optimizes[] = {"NO_OPTIMIZE", "OPTIMIZE_ALL", "OPTIMIZE_BEST"};
-  ImGui::Combo("FINE_OPTIMIZE", (int *)&FINE_OPTIMIZE, optimizes, 3);
+  const char *optimizes[] = {"NO_OPTIMIZE", "OPTIMIZE_ALL", "OPTIMIZE_BEST",
+                             "OPTIMIZE_TOP_K"};
+  ImGui::Combo("FINE_OPTIMIZE", (int *)&FINE_OPTIMIZE, optimizes, 4);
+  if (FINE_OPTIMIZE != NO_OPTIMIZE) {
+    ImGui::SliderInt("FINE_OPTIMIZE_BUDGET", &FINE_OPTIMIZE_BUDGET, 1, 200);
+    const char *methods[] = {"FINE_ADAM", "FINE_NEWTON", "FINE_BFGS"};
+    ImGui::Combo("FINE_METHOD", (int *)&FINE_METHOD, methods, 3);
+  }
+  const char *samplers[] = {"UNIFORM_SAMPLER", "CROSS_ENTROPY_SAMPLER"};
+  ImGui::Combo("FULL_RANDOM_SAMPLER", (int *)&FULL_RANDOM_SAMPLER, samplers,
+               2);
+  ImGui::SliderInt("DECISION_THREADS", &DECISION_THREADS, 1,
+                   MAX_DECISION_THREADS);
+  ImGui::InputInt("DECISION_SEED", &DECISION_SEED);
+  if (DECISION_SEED < 0)
+    DECISION_SEED = 0;
+  ImGui::Checkbox("LOG_DECISIONS", &LOG_DECISIONS);
+  ImGui::SliderInt("EVAL_BATCH_SIZE", &EVAL_BATCH_SIZE, 1, MAX_EVAL_BATCH);
+  if (MAX_DEPTH > 0) {
+    ImGui::SliderInt("MINIMAX_BRANCHING", &MINIMAX_BRANCHING, 1,
+                     MAX_MINIMAX_BRANCHING);
+    ImGui::Checkbox("TRANSPOSITION_TABLE", &TRANSPOSITION_TABLE);
+    if (TRANSPOSITION_TABLE) {
+      ImGui::SliderFloat("TRANSPOSITION_RESOLUTION", &TRANSPOSITION_RESOLUTION,
+                         0.02, 1.0);
+      ImGui::SliderInt("TRANSPOSITION_MAX_AGE", &TRANSPOSITION_MAX_AGE, 0, 16);
+    }
+  }
+  ImGui::Checkbox("PRUNE_EVALUATION", &PRUNE_EVALUATION);
+  ImGui::Checkbox("DELTA_EVALUATION", &DELTA_EVALUATION);
+  ImGui::Checkbox("SIMD_SHADOWS", &SIMD_SHADOWS);
+  ImGui::Checkbox("GAP_FIELD", &GAP_FIELD);
+  if (GAP_FIELD)
+    ImGui::SliderFloat("GAP_FIELD_RESOLUTION", &GAP_FIELD_RESOLUTION, 0.02,
+                       0.5);
+  ImGui::Checkbox("ANALYTIC_GRADIENT", &ANALYTIC_GRADIENT);
+  if (!ANALYTIC_GRADIENT)
+    ImGui::Checkbox("DUAL_GRADIENT", &DUAL_GRADIENT);
+  ImGui::Checkbox("ADAPTIVE_ALLOCATION", &ADAPTIVE_ALLOCATION);
+  if (ADAPTIVE_ALLOCATION) {
+    ImGui::SliderInt("SOURCE_STALE_TICKS", &SOURCE_STALE_TICKS, 1, 2000);
+    ImGui::SliderFloat("SOURCE_DECAY", &SOURCE_DECAY, 0.5, 1.0);
+    ImGui::SliderFloat("SOURCE_EXPLORATION", &SOURCE_EXPLORATION, 0.0, 0.1);
+  }
+  ImGui::Checkbox("SYNC_TO_PACKETS", &SYNC_TO_PACKETS);
+  if (SYNC_TO_PACKETS)
+    ImGui::SliderFloat("PACKET_MARGIN", &PACKET_MARGIN, 0.0, 0.02);
   ImGui::End();
 
   ImGui::Begin("Calibration");
@@ -637,6 +683,13 @@ void gui_render(void) {
                      MAX_SUGGESTIONS + 2, 20000);
   ImGui::SliderInt("FULL_CHANGE_PERCENTAGE", &FULL_CHANGE_PERCENTAGE, 0, 100);
   ImGui::SliderInt("MAX_DEPTH", &MAX_DEPTH, 0, 3);
+  ImGui::SliderInt("CEM_POPULATION", &CEM_POPULATION, 8, 512);
+  ImGui::SliderInt("CEM_ELITE_PERCENTAGE", &CEM_ELITE_PERCENTAGE, 1, 50);
+  ImGui::SliderInt("ELITE_SIZE", &ELITE_SIZE, 0, MAX_ELITE);
+  if (FINE_OPTIMIZE == OPTIMIZE_TOP_K) {
+    ImGui::SliderInt("FINE_TOP_K", &FINE_TOP_K, 1, MAX_ELITE);
+    ImGui::SliderInt("FINE_TOP_K_PERCENTAGE", &FINE_TOP_K_PERCENTAGE, 0, 90);
+  }
 
 #define SLIDER(V, S, A, B) ImGui::DragFloat(#V, &V, S, A, B)
   SLIDER(KICK_POS_VARIATION, 0.01, 0.0, 1.0);
@@ -664,6 +717,8 @@ void gui_render(void) {
   SLIDER(MOVE_RADIUS_0, 0.05, 0, 10);
   SLIDER(MOVE_RADIUS_1, 0.10, 0, 10);
   SLIDER(MOVE_RADIUS_2, 0.10, 0, 10);
+  SLIDER(CEM_SMOOTHING, 0.01, 0, 1);
+  SLIDER(CEM_MIN_SIGMA, 0.01, 0, 2);
 #undef SLIDER
   ImGui::End();
 
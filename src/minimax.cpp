@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <functional>
+
+#include "minimax.h"
+#include "anytime.h"
+#include "optimization.h"
+#include "eval_context.h"
+#include "packet_clock.h"
+#include "consts.h"
+#include "utils.h"
+#include "rng.h"
+#include "transposition.h"
+
+using namespace std::chrono;
+
+static constexpr float INF = std::numeric_limits<float>::infinity();
+
+// state kept by each search thread, reduced to a single best at the end
+struct MinimaxWorker {
+  ValuedDecision best_vd;
+  // the best answer of the enemy to best_vd, if searched
+  Decision best_reply;
+  bool has_reply = false;
+  MinimaxStats stats;
+  // shared by every worker, null without TRANSPOSITION_TABLE
+  TranspositionTable *tt = nullptr;
+  uint32_t seed;
+  steady_clock::time_point deadline;
+  // set once the deadline passed in the middle of a search
+  bool timeout = false;
+};
+
+// the k-th decision of a player on a ply: the table one first, then moving
+// everyone and a single robot in turn, as decide does
+static Decision sample(const EvalContext &ctx, DecisionTable &table, int k) {
+  if (k == 0)
+    return from_decision_table(table, ctx);
+  if (k % 2)
+    return gen_decision(ctx, table);
+  return gen_decision(ctx, table,
+                      ROBOT_WITH_PLAYER(k / 2 % N_ROBOTS, ctx.player));
+}
+
+// the leaf value of decision, or cutoff if PRUNE_EVALUATION finds it can't be
+// above it: fail hard, so the nodes above carry finite bounds of the window
+static float leaf_value(MinimaxWorker &w, const State &state, Player player,
+                        const Decision &decision, const DecisionTable &table,
+                        float cutoff) {
+  float value = evaluate_with_decision(player, state, decision, table, nullptr,
+                                       PRUNE_EVALUATION ? cutoff : -INF);
+  w.stats.leaves++;
+  if (value == -INF) {
+    w.stats.pruned++;
+    return cutoff;
+  }
+  return value;
+}
+
+// the tables after player takes decision on a ply
+static void next_tables(const DecisionTable *tables, const Decision &decision,
+                        Player player, DecisionTable *next) {
+  next[MIN] = tables[MIN];
+  next[MAX] = tables[MAX];
+  update_decision_table(next[player], decision, player);
+}
+
+// value for player of the best of its sampled decisions on state looking
+// depth plies ahead, fail soft: a value at most alpha or at least beta is
+// only a bound on the real one. Writes the best decision if best is given.
+// The decisions come from the stream of the path to the node, ply plies below
+// the first, so cutoffs don't change what the rest of the tree samples.
+static float negamax(MinimaxWorker &w, const State &state, Player player,
+                     const DecisionTable *tables, int ply, uint64_t path,
+                     int depth, float alpha, float beta, Decision *best) {
+  if (CONSTANT_RATE && steady_clock::now() >= w.deadline) {
+    w.timeout = true;
+    return 0.0;
+  }
+
+  rng_seed(thread_rng(), w.seed + ply, path);
+  EvalContext ctx;
+  eval_context_init(ctx, state, player);
+
+  uint64_t key = 0;
+  TranspositionEntry entry;
+  bool hit = false;
+  if (w.tt) {
+    key = transposition_key(*w.tt, state, player, ctx.rwb);
+    hit = transposition_probe(*w.tt, key, &entry);
+    w.stats.tt_probes++;
+    w.stats.tt_hits += hit;
+  }
+  // the tables and the decisions sampled below a state change between
+  // searches, so the values of older ones only order the decisions
+  if (hit && entry.age == 0 && entry.depth >= depth &&
+      (entry.bound == EXACT || (entry.bound == LOWER && entry.value >= beta) ||
+       (entry.bound == UPPER && entry.value <= alpha))) {
+    w.stats.tt_cutoffs++;
+    if (best)
+      *best = entry.decision;
+    return entry.value;
+  }
+
+  DecisionTable table = tables[player];
+  int count = std::min(std::max(MINIMAX_BRANCHING, 1), MAX_MINIMAX_BRANCHING);
+  Decision decisions[MAX_MINIMAX_BRANCHING + 1];
+  FOR_N(k, count) { decisions[k] = sample(ctx, table, k); }
+  w.stats.expanded++;
+
+  // for earlier cutoffs the best of the transposition table is searched first,
+  // then the best on their own
+  int order[MAX_MINIMAX_BRANCHING + 1];
+  FOR_N(k, count) { order[k + hit] = k; }
+  if (depth > 1) {
+    float own[MAX_MINIMAX_BRANCHING];
+    FOR_N(k, count) {
+      own[k] = evaluate_with_decision(player, state, decisions[k], table);
+    }
+    std::stable_sort(order + hit, order + hit + count,
+                     [&](int a, int b) { return own[a] > own[b]; });
+  }
+  if (hit) {
+    decisions[count] = entry.decision;
+    order[0] = count++;
+  }
+
+  float best_value = -INF;
+  int best_k = 0;
+  FOR_N(n, count) {
+    int k = order[n];
+    w.stats.nodes++;
+    float value;
+    if (depth == 1) {
+      value = leaf_value(w, state, player, decisions[k], table,
+                         std::max(alpha, best_value));
+    } else {
+      State next_state = state;
+      apply_to_state(decisions[k], player, &next_state);
+      DecisionTable next[2];
+      next_tables(tables, decisions[k], player, next);
+      uint64_t next_path = path * (MAX_MINIMAX_BRANCHING + 1) + k;
+      value = -negamax(w, next_state, ENEMY_FOR(player), next, ply + 1,
+                       next_path, depth - 1, -beta,
+                       -std::max(alpha, best_value), nullptr);
+      if (w.timeout)
+        return 0.0;
+    }
+
+    if (value > best_value) {
+      best_value = value;
+      best_k = k;
+    }
+    if (best_value >= beta) {
+      w.stats.cutoffs++;
+      break;
+    }
+  }
+
+  // an infinite bound would pass the probe on any window
+  if (w.tt && std::isfinite(best_value)) {
+    entry.value = best_value;
+    entry.depth = depth;
+    entry.bound = best_value >= beta    ? LOWER
+                  : best_value <= alpha ? UPPER
+                                        : EXACT;
+    entry.decision = decisions[best_k];
+    transposition_store(*w.tt, key, entry);
+  }
+
+  if (best)
+    *best = decisions[best_k];
+  return best_value;
+}
+
+// searches every n_workers-th decision of the first ply starting at worker,
+// keeping the best
+static void search(MinimaxWorker &w, int worker, int n_workers, Minimax &mm,
+                   const State &state, Player player, int depth) {
+  EvalContext ctx;
+  eval_context_init(ctx, state, player);
+  DecisionTable table = mm.table[player];
+  w.best_vd.value = -INF;
+
+  for (int i = worker;; i += n_workers) {
+    // every decision has its own stream so the outcome doesn't depend on
+    // which worker drew it
+    rng_seed(thread_rng(), mm.seed, i);
+    Decision decision = sample(ctx, table, i);
+
+    float value;
+    Decision reply;
+    if (depth == 1) {
+      value = leaf_value(w, state, player, decision, table, w.best_vd.value);
+    } else {
+      State next_state = state;
+      apply_to_state(decision, player, &next_state);
+      DecisionTable next[2];
+      next_tables(mm.table, decision, player, next);
+      value = -negamax(w, next_state, ENEMY_FOR(player), next, 1, i,
+                       depth - 1, -INF, -w.best_vd.value, &reply);
+      if (w.timeout)
+        break;
+    }
+    w.stats.nodes++;
+
+    if (value > w.best_vd.value) {
+      w.best_vd.value = value;
+      w.best_vd.decision = decision;
+      w.best_reply = reply;
+      w.has_reply = depth > 1;
+
+      if (mm.anytime)
+        anytime_publish(*mm.anytime, worker, value, decision);
+    }
+
+    // check stop condition
+    if (CONSTANT_RATE) {
+      if (steady_clock::now() >= w.deadline)
+        break;
+    } else if (i + n_workers >= RAMIFICATION_NUMBER) {
+      break;
+    }
+  }
+}
+
+ValuedDecision minimax_decide(Minimax &mm, const State &state, Player player) {
+  if (!mm.table_initialized) {
+    mm.table_initialized = true;
+    FOR_EVERY_ROBOT(i) {
+      mm.table[PLAYER_OF(i)].move[i] = make_move_action(state.robots[i]);
+    }
+  }
+
+  const auto start = steady_clock::now();
+  const auto deadline = decision_deadline(start, mm.clock);
+  mm.seed = DECISION_SEED > 0 ? DECISION_SEED : rng_fresh_seed();
+  // a searched value of the previous decision needs a search, the one it was
+  // found with stands in until something beats it
+  if (mm.anytime) {
+    EvalContext ctx;
+    eval_context_init(ctx, state, player);
+    rng_seed(thread_rng(), mm.seed, 0);
+    anytime_begin(*mm.anytime, mm.value,
+                  from_decision_table(mm.table[player], ctx));
+  }
+  if (TRANSPOSITION_TABLE)
+    transposition_new_search(mm.transposition, TRANSPOSITION_RESOLUTION,
+                             params_signature());
+  int depth = std::max(MAX_DEPTH, 1);
+
+  int n_workers = std::min(std::max(DECISION_THREADS, 1), MAX_DECISION_THREADS);
+  MinimaxWorker workers[MAX_DECISION_THREADS];
+  std::thread threads[MAX_DECISION_THREADS];
+  FOR_N(k, n_workers) {
+    workers[k].seed = mm.seed;
+    if (TRANSPOSITION_TABLE)
+      workers[k].tt = &mm.transposition;
+    workers[k].deadline = deadline;
+  }
+  FOR_RANGE(k, 1, n_workers) {
+    threads[k] = std::thread(search, std::ref(workers[k]), k, n_workers,
+                             std::ref(mm), std::cref(state), player, depth);
+  }
+  search(workers[0], 0, n_workers, mm, state, player, depth);
+  FOR_RANGE(k, 1, n_workers) { threads[k].join(); }
+
+  mm.stats = MinimaxStats();
+  MinimaxWorker *best = &workers[0];
+  FOR_N(k, n_workers) {
+    auto &w = workers[k];
+    if (w.best_vd.value > best->best_vd.value)
+      best = &w;
+    mm.stats.nodes += w.stats.nodes;
+    mm.stats.leaves += w.stats.leaves;
+    mm.stats.pruned += w.stats.pruned;
+    mm.stats.expanded += w.stats.expanded;
+    mm.stats.cutoffs += w.stats.cutoffs;
+    mm.stats.tt_probes += w.stats.tt_probes;
+    mm.stats.tt_hits += w.stats.tt_hits;
+    mm.stats.tt_cutoffs += w.stats.tt_cutoffs;
+  }
+
+  ValuedDecision vd = best->best_vd;
+  Player enemy = ENEMY_FOR(player);
+  // the deadline passed before any decision was searched through
+  if (vd.value == -INF) {
+    EvalContext ctx;
+    eval_context_init(ctx, state, player);
+    vd.decision = from_decision_table(mm.table[player], ctx);
+    vd.value = evaluate_with_decision(player, state, vd.decision,
+                                      mm.table[player]);
+    if (mm.anytime)
+      anytime_publish(*mm.anytime, 0, vd.value, vd.decision);
+  } else if (best->has_reply) {
+    update_decision_table(mm.table[enemy], best->best_reply, enemy);
+  }
+  update_decision_table(mm.table[player], vd.decision, player);
+
+  mm.seconds = duration<double>(steady_clock::now() - start).count();
+  mm.value = vd.value;
+  return vd;
+}
@@ -1,10 +1,60 @@
 #ifndef MINIMAX_H
 #define MINIMAX_H
 
+#include <stdint.h>
+#include <limits>
+
 #include "decision.h"
+#include "decision_table.h"
+#include "transposition.h"
+#include "valued_decision.h"
+
+// Depth limited alpha-beta (negamax) over MAX_DEPTH plies, the players taking
+// turns from the one deciding. The first ply samples candidates like decide()
+// does, until the same deadline, every ply below samples MINIMAX_BRANCHING
+// decisions with gen_decision() and tries them best first by their own value.
+// The last ply is scored by evaluate_with_decision() for the player on it and
+// negated on the way up, with PRUNE_EVALUATION against the best known so far;
+// a leaf cut short is worth that best, which bounds its value from above.
+// With TRANSPOSITION_TABLE every node below the first ply is kept on a table
+// that outlives the search: a node found there searched as deep by the same
+// search skips its search if the bound stored allows, otherwise its stored
+// best goes first.
+
+struct MinimaxStats {
+  // decisions scored or searched below, of those how many were evaluated as
+  // leaves and how many of these were cut short by the evaluation
+  long nodes = 0, leaves = 0, pruned = 0;
+  // nodes below the first ply whose decisions were searched, and of those
+  // how many skipped some on a beta cutoff
+  long expanded = 0, cutoffs = 0;
+  // nodes looked up on the transposition table, of those how many were found
+  // and how many of these returned without a search
+  long tt_probes = 0, tt_hits = 0, tt_cutoffs = 0;
+};
 
-struct Minimax {};
+struct Minimax {
+  // the actions each player is expected to keep, indexed by Player
+  DecisionTable table[2];
+  bool table_initialized = false;
+  TranspositionTable transposition;
+  // if set every first ply improvement found while searching is published
+  // here, on a generation of its own that starts with the table decision
+  // worth the value of the last search
+  struct AnytimeDecision *anytime = nullptr;
+  // if set and SYNC_TO_PACKETS the search ends right before the next packet
+  struct PacketClock *clock = nullptr;
+  // seed of the last search, candidate i of the first ply is drawn from
+  // stream i and the decisions of a node below from the stream of its path
+  uint32_t seed = 0;
+  // of the last search
+  MinimaxStats stats;
+  double seconds = 0.0;
+  float value = -std::numeric_limits<float>::infinity();
+};
 
-// TODO
+// the best first ply decision for player, with its searched value; keeps it
+// and the best answer to it on the tables
+ValuedDecision minimax_decide(Minimax &mm, const State &state, Player player);
 
 #endif
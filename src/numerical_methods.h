@@ -4,6 +4,8 @@
  *            by professor José Paulo P. Dieguez          *
  *  - "Calculus Volume II",                               *
  *            by Tom M. Apostol                           *
+ *  - "Numerical Optimization",                           *
+ *            by Jorge Nocedal and Stephen J. Wright      *
  **********************************************************/
 #ifndef MOVE_SOLVER_H
 #define MOVE_SOLVER_H
@@ -11,35 +13,82 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <tuple>
-#include <array>
 #include <algorithm>
 
-#include <boost/numeric/ublas/assignment.hpp>
-#include <boost/numeric/ublas/vector.hpp>
-#include <boost/numeric/ublas/matrix.hpp>
-#include <boost/numeric/ublas/matrix_proxy.hpp>
-#include <boost/numeric/ublas/io.hpp>
-#include <mat2cpp.hpp>
-#include "lapacke.h"
-
 namespace numerical_method {
 
-using namespace boost::numeric::ublas;
-using namespace mat2cpp;
 using namespace std;
 using num = double;
-using mat = matrix<num>;
-using zeros = zero_matrix<num>;
-using iden = identity_matrix<num>;
-using vec = boost::numeric::ublas::vector<num>;
 
-template <typename T> num norm(const T e) {
-  return max(abs(max(e)), abs(min(e)));
+// Vectors and matrices have their dimension fixed at compile time and live
+// on the stack, nothing here allocates.
+template <int N> struct vec {
+  num _[N] = {};
+  num &operator()(int i) { return _[i]; }
+  num operator()(int i) const { return _[i]; }
+};
+
+template <int N> struct mat {
+  num _[N][N] = {};
+  num &operator()(int i, int j) { return _[i][j]; }
+  num operator()(int i, int j) const { return _[i][j]; }
+};
+
+template <int N> vec<N> operator+(const vec<N> &a, const vec<N> &b) {
+  vec<N> c;
+  for (int i = 0; i < N; i++)
+    c(i) = a(i) + b(i);
+  return c;
+}
+
+template <int N> vec<N> operator-(const vec<N> &a, const vec<N> &b) {
+  vec<N> c;
+  for (int i = 0; i < N; i++)
+    c(i) = a(i) - b(i);
+  return c;
+}
+
+template <int N> vec<N> operator*(num k, const vec<N> &a) {
+  vec<N> c;
+  for (int i = 0; i < N; i++)
+    c(i) = k * a(i);
+  return c;
+}
+
+template <int N> mat<N> operator*(num k, const mat<N> &A) {
+  mat<N> B;
+  for (int i = 0; i < N; i++)
+    for (int j = 0; j < N; j++)
+      B(i, j) = k * A(i, j);
+  return B;
+}
+
+template <int N> vec<N> operator*(const mat<N> &A, const vec<N> &x) {
+  vec<N> y;
+  for (int i = 0; i < N; i++)
+    for (int j = 0; j < N; j++)
+      y(i) += A(i, j) * x(j);
+  return y;
+}
+
+template <int N> num inner_prod(const vec<N> &a, const vec<N> &b) {
+  num s = 0;
+  for (int i = 0; i < N; i++)
+    s += a(i) * b(i);
+  return s;
+}
+
+template <int N> num norm(const vec<N> &e) { return sqrt(inner_prod(e, e)); }
+
+template <int N> mat<N> identity(num k = 1.0) {
+  mat<N> I;
+  for (int i = 0; i < N; i++)
+    I(i, i) = k;
+  return I;
 }
-num norm(const vec e) { return sqrt(inner_prod(e, e)); }
 
-// N_MAX: maximum value above which computer freezes
-#define N_MAX 2000
+// N_SWEEPS: maximum number of jacobi rotation sweeps
+#define N_SWEEPS 50
 #define DELTA 0.0001
 #define MAX_VALUE 3000
 #define MAX_IT 100
@@ -49,10 +98,10 @@ num norm(const vec e) { return sqrt(inner_prod(e, e)); }
 /************
  * Gradiend *
  ************/
-vec grad(num (*f)(const vec), const vec x) {
-  vec grad(x.size());
-  for (unsigned int i = 0; i < x.size(); i++) {
-    vec x_pls_delta = x, x_mns_delta = x;
+template <int N, typename F> vec<N> grad(F f, const vec<N> &x) {
+  vec<N> grad;
+  for (int i = 0; i < N; i++) {
+    vec<N> x_pls_delta = x, x_mns_delta = x;
     // using central diferences
     x_pls_delta(i) += DELTA;
     x_mns_delta(i) += -DELTA;
@@ -66,13 +115,11 @@ vec grad(num (*f)(const vec), const vec x) {
  * (gamma < 0) or ascendent (gamma > 0) method, depending *
  * on the sinal of gamma.                                 *
  **********************************************************/
-tuple<vec, num> grad_min(num (*f)(const vec), const vec x_init,
-                         const num gamma) {
-  vec x_k(x_init.size()), x_buff(x_init.size());
+template <int N, typename F>
+tuple<vec<N>, num> grad_min(F f, const vec<N> &x_init, const num gamma) {
+  vec<N> x_k = x_init, x_buff;
   unsigned int n_it = 1;
   num erro = 1;
-  // setup initial value of x_k
-  x_k = x_init;
   // main loop
   while (n_it < MAX_IT && (erro > TOL)) {
     n_it = 1 + n_it;
@@ -80,136 +127,264 @@ tuple<vec, num> grad_min(num (*f)(const vec), const vec x_init,
     x_buff = x_k + gamma * grad(f, x_k);
     // check if something went wrong and go to zero
     if (norm(x_buff) > MAX_VALUE) {
-      x_buff *= 0.0;
+      x_buff = vec<N>();
     }
     // compute the error in x and update x_k
-    x_buff -= x_k;
+    x_buff = x_buff - x_k;
     erro = norm(x_buff);
-    x_k += x_buff;
+    x_k = x_k + x_buff;
   }
 
   return make_tuple(x_k, erro);
 }
 
-/*********************************
- * Computation of Hessian matrix *
- *********************************/
-int eig(const mat &_A, num *eigen_values) {
-  int info = 0, n = _A.size1(), order_of_A = _A.size1(),
-      size_work_array = _A.size1() * 42;
-  num *A = nullptr, *work_array = nullptr;
-  // dont calculate eigenvectors
-  char return_eigen_vectors = 'N', upper_lower_triag = 'U';
-  // check if matrix _A is square
-  if (_A.size1() == _A.size2()) {
-    // allocate memory
-    A = new num[n * n], work_array = new num[size_work_array];
-    // free memory
-    copy(_A.data().begin(), _A.data().end(), A);
-    // call lapack subrotine
-    // XXX: This only works with double!!!
-    LAPACK_dsyev(&return_eigen_vectors, &upper_lower_triag, &order_of_A, A, &n,
-                 eigen_values, work_array, &size_work_array, &info);
-  } else {
-    info = -1;
+/***************************************************
+ * Lowest and greatest eigen values of a symmetric *
+ * matrix, by cyclic jacobi rotations              *
+ ***************************************************/
+template <int N> tuple<num, num> max_min_eigs(mat<N> A) {
+  for (int sweep = 0; sweep < N_SWEEPS; sweep++) {
+    num off = 0;
+    for (int p = 0; p < N; p++)
+      for (int q = p + 1; q < N; q++)
+        off += A(p, q) * A(p, q);
+    if (off < 1e-24)
+      break;
+
+    for (int p = 0; p < N; p++) {
+      for (int q = p + 1; q < N; q++) {
+        if (A(p, q) == 0)
+          continue;
+        // rotation that zeroes A(p,q)
+        num theta = (A(q, q) - A(p, p)) / (2 * A(p, q));
+        num t = (theta >= 0 ? 1 : -1) /
+                (abs(theta) + sqrt(theta * theta + 1));
+        num c = 1 / sqrt(t * t + 1), s = t * c;
+        for (int k = 0; k < N; k++) {
+          num akp = A(k, p), akq = A(k, q);
+          A(k, p) = c * akp - s * akq;
+          A(k, q) = s * akp + c * akq;
+        }
+        for (int k = 0; k < N; k++) {
+          num apk = A(p, k), aqk = A(q, k);
+          A(p, k) = c * apk - s * aqk;
+          A(q, k) = s * apk + c * aqk;
+        }
+      }
+    }
   }
-  // free memory
-  delete A;
-  delete work_array;
 
-  return info;
-}
-// compute greatest and lowest eigenvalues
-tuple<num, num, int> max_min_eigs(const mat &A) {
-  num *eigenvalues = new num[A.size1()], max = 0, min = 0;
-  int info = -1;
-  // check for maximum size
-  if (A.size1() < N_MAX) {
-    // compute eigenvalues
-    info = eig(A, eigenvalues);
-    // lowest eigen value
-    min = eigenvalues[0];
-    // greatest eigen value
-    max = eigenvalues[A.size1() - 1];
+  num max = A(0, 0), min = A(0, 0);
+  for (int i = 1; i < N; i++) {
+    max = std::max(max, A(i, i));
+    min = std::min(min, A(i, i));
   }
-  // free memory
-  delete eigenvalues;
-  return make_tuple(max, min, info);
+  return make_tuple(max, min);
 }
-// compute hessian and its greatest and lowest eigenvalues
-tuple<mat, num, num, int> hessian(num (*f)(const vec), const vec x) {
-  // Hessian matrix
-  mat H = zeros(x.size(), x.size());
+
+/*********************************
+ * Computation of Hessian matrix *
+ *********************************/
+// from the gradient g, returns the hessian and its lowest and greatest
+// eigen values; coordinates not active (if given) are held fixed, they get
+// an identity row and column and cost no gradient
+template <int N, typename G>
+tuple<mat<N>, num, num> hessian_of_grad(G g, const vec<N> &x,
+                                        num delta = TOL,
+                                        const bool *active = nullptr) {
+  mat<N> H;
   num eig_min, eig_max;
-  vec x_n(x.size()), x_p(x.size());
-  int info = -1;
-
-  for (unsigned i = 0; i < x.size(); i++) {
-    x_n = x;
-    x_n(i) += -TOL;
-    x_p = x;
-    x_p(i) += +TOL;
+
+  for (int i = 0; i < N; i++) {
+    if (active && !active[i]) {
+      H(i, i) = 1;
+      continue;
+    }
+    vec<N> x_n = x, x_p = x;
+    x_n(i) += -delta;
+    x_p(i) += +delta;
     // Hessian
     // H(:,1)'= del  f1        del  fn
     //         -----   , ..., -----
     //         del x1         del x1
-    row(H, i) = (grad(f, x_p) - grad(f, x_n)) * (1.0 / (2 * TOL));
+    vec<N> row = (1.0 / (2 * delta)) * (g(x_p) - g(x_n));
+    for (int j = 0; j < N; j++)
+      H(i, j) = row(j);
+  }
+  // the rows should match the columns, the noise of the differences may
+  // make them differ a little, keep the symmetric part
+  for (int i = 0; i < N; i++) {
+    for (int j = i + 1; j < N; j++) {
+      num h = (H(i, j) + H(j, i)) / 2;
+      H(i, j) = H(j, i) = h;
+    }
   }
-  // Note that we changed the rows for the columns, so it would
-  // be good to transpose H, but it should be simetric... but
-  // for the sake of readability, it is here: H = trans(H);
 
   // get minimum and maximun eigen value
-  tie(eig_max, eig_min, info) = max_min_eigs(H);
+  tie(eig_max, eig_min) = max_min_eigs(H);
+
+  return make_tuple(H, eig_min, eig_max);
+}
+
+template <int N, typename F>
+tuple<mat<N>, num, num> hessian(F f, const vec<N> &x) {
+  return hessian_of_grad([&](const vec<N> &y) { return grad(f, y); }, x);
+}
+
+/*********************************************
+ * Solve A.x = b, gaussian elimination with  *
+ * partial pivoting, false if A is singular  *
+ *********************************************/
+template <int N> bool solve(mat<N> A, vec<N> b, vec<N> &x) {
+  for (int k = 0; k < N; k++) {
+    int p = k;
+    for (int i = k + 1; i < N; i++)
+      if (abs(A(i, k)) > abs(A(p, k)))
+        p = i;
+    if (A(p, k) == 0)
+      return false;
+    if (p != k) {
+      for (int j = 0; j < N; j++)
+        swap(A(k, j), A(p, j));
+      swap(b(k), b(p));
+    }
+    for (int i = k + 1; i < N; i++) {
+      num m = A(i, k) / A(k, k);
+      for (int j = k; j < N; j++)
+        A(i, j) -= m * A(k, j);
+      b(i) -= m * b(k);
+    }
+  }
+  for (int i = N - 1; i >= 0; i--) {
+    num s = b(i);
+    for (int j = i + 1; j < N; j++)
+      s -= A(i, j) * x(j);
+    x(i) = s / A(i, i);
+  }
+  return true;
+}
+
+/*********************************************
+ * Solve A.x = b by cholesky factorization,  *
+ * false if A is not positive definite       *
+ *********************************************/
+template <int N> bool cholesky_solve(const mat<N> &A, vec<N> b, vec<N> &x) {
+  mat<N> L;
+  for (int j = 0; j < N; j++) {
+    num d = A(j, j);
+    for (int k = 0; k < j; k++)
+      d -= L(j, k) * L(j, k);
+    if (!(d > 0))
+      return false;
+    L(j, j) = sqrt(d);
+    for (int i = j + 1; i < N; i++) {
+      num s = A(i, j);
+      for (int k = 0; k < j; k++)
+        s -= L(i, k) * L(j, k);
+      L(i, j) = s / L(j, j);
+    }
+  }
+  // L.y = b then L'.x = y
+  for (int i = 0; i < N; i++) {
+    for (int k = 0; k < i; k++)
+      b(i) -= L(i, k) * b(k);
+    b(i) /= L(i, i);
+  }
+  for (int i = N - 1; i >= 0; i--) {
+    num s = b(i);
+    for (int k = i + 1; k < N; k++)
+      s -= L(k, i) * x(k);
+    x(i) = s / L(i, i);
+  }
+  return true;
+}
 
-  return make_tuple(H, eig_min, eig_max, info);
+/**********************************************************
+ * Newton direction p of H.p = -g, H is shifted by a      *
+ * multiple of the identity until it's positive definite, *
+ * false if no shift up to max_shift makes it so          *
+ **********************************************************/
+template <int N>
+bool newton_direction(mat<N> H, const vec<N> &g, vec<N> &p,
+                      num max_shift = 1e6) {
+  num shift = 0, scale = 0;
+  for (int i = 0; i < N; i++)
+    scale = std::max(scale, abs(H(i, i)));
+  scale = std::max(scale * 1e-3, 1e-6);
+  while (!cholesky_solve(H, -1.0 * g, p)) {
+    num next = shift > 0 ? shift * 4 : scale;
+    if (next > max_shift)
+      return false;
+    for (int i = 0; i < N; i++)
+      H(i, i) += next - shift;
+    shift = next;
+  }
+  return true;
+}
+
+/**********************************************************
+ * BFGS update of the inverse hessian approximation H_inv *
+ * after a step s that changed the gradient by y, skipped *
+ * (returning false) when the curvature s'.y isn't        *
+ * positive                                               *
+ **********************************************************/
+template <int N>
+bool bfgs_update(mat<N> &H_inv, const vec<N> &s, const vec<N> &y) {
+  num sy = inner_prod(s, y);
+  if (!(sy > 1e-12))
+    return false;
+  num rho = 1 / sy;
+  // H_inv = (I - rho.s.y') H_inv (I - rho.y.s') + rho.s.s'
+  vec<N> Hy = H_inv * y;
+  num yHy = inner_prod(y, Hy);
+  for (int i = 0; i < N; i++) {
+    for (int j = 0; j < N; j++) {
+      H_inv(i, j) += rho * ((1 + rho * yHy) * s(i) * s(j) - Hy(i) * s(j) -
+                            s(i) * Hy(j));
+    }
+  }
+  return true;
 }
 
 /**********************************************************
  * Find inflexion point using newton method               *
  **********************************************************/
-tuple<vec,num,num,num,int> newton_min(num (*f)(const vec), const vec x) {
-  unsigned int N = x.size(), n_it = 1;
-  int info = -1;
-  num erro = 1, eig_min, eig_max;
-  mat H(N, N), _grad(N, 1);
+template <int N, typename F>
+tuple<vec<N>, num, num, num> newton_min(F f, const vec<N> &x) {
+  unsigned int n_it = 1;
+  num erro = 1, eig_min = 0, eig_max = 0;
+  mat<N> H;
   // Initial value for x
-  vec x_k(N), z(N);
-  x_k = x;
+  vec<N> x_k = x, z;
   // Main iteration loop
   while (n_it < MAX_IT && erro > TOL) {
     n_it += 1;
     // Compute hessian matrix
     // One need to analize the eigen values to find the type of
     // inflexion point
-    tie(H, eig_min, eig_max, info) = hessian(f, x_k);
+    tie(H, eig_min, eig_max) = hessian(f, x_k);
     // Solve H.z = -grad(f), (on octave: z = H \ - grad_f(x_k, TOL))
-    // transform vector to matrix, using z as a buffer here
-    size_t _r;
-    z = -grad(f, x_k);
-    copy(z.begin(), z.end(), _grad.begin1());
-    z = column(matrix_div(H, _grad, _r), 0);
+    if (!solve(H, -1.0 * grad(f, x_k), z))
+      break;
     // increment size
-    x_k += z;
+    x_k = x_k + z;
     erro = norm(z);
   }
-  // TODO: pass info in a better way
-  return make_tuple(x_k, erro, eig_min, eig_max, info);
+  return make_tuple(x_k, erro, eig_min, eig_max);
 }
 
 /***************************************************************
  * Find local minimal or maximal point using newton method and *
  * gradient method                                             *
  ***************************************************************/
-tuple<vec, num> newton_grad(num (*f)(const vec), const vec x_0, const num gamma,
-                            const bool find_minimum) {
+template <int N, typename F>
+tuple<vec<N>, num> newton_grad(F f, const vec<N> &x_0, const num gamma,
+                               const bool find_minimum) {
   // initial values
-  unsigned int n_it = 1, n_sub_it = 1, n = x_0.size();
-  int info = -1;
+  unsigned int n_it = 1, n_sub_it = 1;
   num erro = 1, eig_min, eig_max;
-  vec x_k(n);
-  x_k = x_0;
-  mat H(n, n);
+  vec<N> x_k = x_0;
+  mat<N> H;
   // Main iteration loop
   while (n_it < MAX_IT && erro > TOL) {
     n_sub_it = 1;
@@ -219,7 +394,7 @@ tuple<vec, num> newton_grad(num (*f)(const vec), const vec x_0, const num gamma,
     // fast in that points. For this to be done, it is necessary to
     // discover
     // the type of stationary point.
-    tie(H, eig_min, eig_max, info) = hessian(f, x_k);
+    tie(H, eig_min, eig_max) = hessian(f, x_k);
     // All eigen values must have the same signal on an extremal point
     // (if some conditions are satisfied, vide apostol volume II)
     if (find_minimum) {
@@ -228,7 +403,7 @@ tuple<vec, num> newton_grad(num (*f)(const vec), const vec x_0, const num gamma,
       while ((eig_min < 0 || eig_min * eig_max < 0) && n_sub_it < MAX_SUB_IT) {
         n_sub_it += 1;
         tie(x_k, erro) = grad_min(f, x_k, -gamma);
-        tie(H, eig_min, eig_max, info) = hessian(f, x_k);
+        tie(H, eig_min, eig_max) = hessian(f, x_k);
       }
     } else {
       // MAXIMUM: all eigen values must be negative
@@ -236,7 +411,7 @@ tuple<vec, num> newton_grad(num (*f)(const vec), const vec x_0, const num gamma,
       while ((eig_min > 0 || eig_min * eig_max < 0) && n_sub_it < MAX_SUB_IT) {
         n_sub_it += 1;
         tie(x_k, erro) = grad_min(f, x_k, gamma);
-        tie(H, eig_min, eig_max, info) = hessian(f, x_k);
+        tie(H, eig_min, eig_max) = hessian(f, x_k);
       }
     }
     // end main if the eigen values did not change
@@ -245,18 +420,17 @@ tuple<vec, num> newton_grad(num (*f)(const vec), const vec x_0, const num gamma,
     }
     // this is done after to avoid inflexion points, because things
     // may go to space if we go to this points
-    tie(x_k, erro, eig_min, eig_max, info) = newton_min(f, x_k);
-    // NOTE: If the Hessian is not symetric, then some eigen values
-    // can be complex. But this is not verified here
+    tie(x_k, erro, eig_min, eig_max) = newton_min(f, x_k);
+    // NOTE: the hessian is symmetrized so every eigen value is real
   }
   return make_tuple(x_k, erro);
 }
 // undefining local defines
+#undef N_SWEEPS
 #undef DELTA
 #undef MAX_VALUE
 #undef MAX_IT
 #undef TOL
-#undef N_MAX
 #undef MAX_SUB_IT
 }
 
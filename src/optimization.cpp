@@ -4,6 +4,9 @@
 #include <limits>
 #include <chrono>
 #include <algorithm>
+#include <thread>
+#include <functional>
+#include <new>
 
 #include "optimization.h"
 #include "utils.h"
@@ -11,7 +14,239 @@
 #include "vector.h"
 #include "suggestions.h"
 #include "decision_source.h"
+#include "cross_entropy.h"
+#include "anytime.h"
+#include "packet_clock.h"
+#include "delta_eval.h"
+#include "gap_field.h"
+#include "eval_context.h"
+#include "rng.h"
+#include "simd.h"
 #include "app.h"
+#include "numerical_methods.h"
+#include "constraints.h"
+
+// state kept by each search thread, reduced to a single best at the end
+struct SearchWorker {
+  ValuedDecision best_vd;
+  // sample index of best_vd, used to break ties deterministically
+  int best_i = -1;
+  // this should point to a suggestion if one leads to the best decision
+  SuggestionTable *best_suggestion = nullptr;
+  int best_suggestion_i = -1;
+  DecisionSource best_source = NO_SOURCE;
+  int count = 0;
+  int pruned_count = 0;
+  int source_count[N_SOURCES] = {};
+  // what optimize_decision added to best_vd
+  float best_gain = 0.0;
+  // adaptive sampler for FULL_RANDOM candidates
+  CrossEntropy cem;
+  // best distinct candidates seen by this worker
+  ElitePool elite;
+  // the FINE_TOP_K best distinct candidates if OPTIMIZE_TOP_K
+  ElitePool top;
+  // partial results of the table decision, shared by every candidate
+  DeltaEval delta;
+};
+
+Optimization::Optimization() = default;
+Optimization::~Optimization() = default;
+
+// a worker as new, in place: a temporary would be on the stack
+static void reset(SearchWorker &w) {
+  w.~SearchWorker();
+  new (&w) SearchWorker();
+}
+
+// where a candidate comes from, kept next to it while it's evaluated
+struct Candidate {
+  int i;
+  DecisionSource source;
+  SuggestionTable *suggestion = nullptr;
+  int suggestion_i = -1;
+};
+
+static Decision gen_candidate(SearchWorker &w, Candidate &c, Optimization &opt,
+                              const EvalContext &ctx, Suggestions *suggestions,
+                              const ElitePool &seeds) {
+  int i = c.i;
+  int n_suggestions = suggestions ? suggestions->tables_count : 0;
+
+  // every candidate has its own stream so the outcome doesn't depend on
+  // which worker drew it
+  rng_seed(thread_rng(), opt.seed, i);
+
+  // always consider the previous decision (based on the decision
+  // table)
+  // unless it's a kick action, those can only happen if kick
+  if (suggestions && i < suggestions->tables_count) {
+    c.suggestion = &suggestions->tables[i];
+    c.suggestion_i = i;
+    c.source = SUGGESTION;
+    return gen_decision(*c.suggestion, ctx, opt.table);
+  } else if (i == n_suggestions) {
+    c.source = TABLE;
+    return from_decision_table(opt.table, ctx);
+    // then the best decisions of the previous decide
+  } else if (i <= n_suggestions + seeds.count) {
+    auto &seed = seeds.entries[i - n_suggestions - 1];
+    c.source = ELITE;
+    return from_elite(seed.decision, opt.table, ctx);
+  }
+
+  // the random sources the bandit tries get the first candidate each
+  const Allocation &alloc = opt.allocation;
+  int r = i - n_suggestions - seeds.count - 1;
+  bool full;
+  if (r == 0 && alloc.full_random)
+    full = true;
+  else if (r == alloc.full_random && alloc.single_random)
+    full = false;
+  else
+    full = 100.0 * i / RAMIFICATION_NUMBER < alloc.full_change_percentage;
+
+  // on some cases try to move everyone at once, this may lead to
+  // better
+  // results
+  if (full) {
+    c.source = FULL_RANDOM;
+    if (FULL_RANDOM_SAMPLER == CROSS_ENTROPY_SAMPLER)
+      return gen_decision(ctx, opt.table, w.cem);
+    else
+      return gen_decision(ctx, opt.table);
+    // on everything else roun-robin between trying to move each robot
+  } else {
+    c.source = SINGLE_RANDOM;
+    return gen_decision(ctx, opt.table, opt.robot_to_move);
+  }
+}
+
+// a candidate not above this can't change the best, the elite nor the sampler
+// of the worker, pending is how many candidates are processed before it
+static float search_cutoff(const SearchWorker &w, const Candidate &c,
+                           int pending) {
+  if (!PRUNE_EVALUATION || FINE_OPTIMIZE == OPTIMIZE_ALL)
+    return -std::numeric_limits<float>::infinity();
+
+  float cutoff = w.best_vd.value;
+  if (ELITE_SIZE > 0)
+    cutoff = std::min(cutoff, elite_threshold(w.elite, ELITE_SIZE));
+  if (c.source == FULL_RANDOM && FULL_RANDOM_SAMPLER == CROSS_ENTROPY_SAMPLER)
+    cutoff = std::min(cutoff, cem_threshold(w.cem, pending));
+  if (FINE_OPTIMIZE == OPTIMIZE_TOP_K)
+    cutoff = std::min(cutoff, elite_threshold(w.top, FINE_TOP_K));
+  return cutoff;
+}
+
+// samples every n_workers-th candidate starting at worker, keeping the best,
+// candidates are evaluated EVAL_BATCH_SIZE at a time
+static void search(SearchWorker &w, int worker, int n_workers,
+                   Optimization &opt, const EvalContext &ctx,
+                   Suggestions *suggestions, const ElitePool &seeds,
+                   const GapField *field,
+                   std::chrono::steady_clock::time_point deadline) {
+
+  using namespace std::chrono;
+  auto &state = *ctx.state;
+  Player player = ctx.player;
+
+  w.best_vd.value = -std::numeric_limits<float>::infinity();
+  int batch_size = std::min(std::max(EVAL_BATCH_SIZE, 1), MAX_EVAL_BATCH);
+
+  // most candidates keep the table moves of all but a few robots
+  DeltaEval *delta = nullptr;
+  if (DELTA_EVALUATION) {
+    delta_init(w.delta, ctx, opt.table);
+    delta = &w.delta;
+  }
+
+  int i = worker;
+  while (true) {
+    // FOR_N(i, RAMIFICATION_NUMBER) {
+    ValuedDecision batch[MAX_EVAL_BATCH];
+    Candidate candidates[MAX_EVAL_BATCH];
+    int count = 0;
+
+    do {
+      auto &c = candidates[count];
+      c.i = i;
+      batch[count].decision =
+          gen_candidate(w, c, opt, ctx, suggestions, seeds);
+      count++;
+      i += n_workers;
+    } while (count < batch_size && (CONSTANT_RATE || i < RAMIFICATION_NUMBER));
+
+    // the thresholds only go up while the batch is processed
+    float cutoffs[MAX_EVAL_BATCH];
+    FOR_N(k, count) { cutoffs[k] = search_cutoff(w, candidates[k], k); }
+
+    w.pruned_count +=
+        evaluate_batch(ctx, batch, count, opt.table, cutoffs, delta, field);
+
+    FOR_N(k, count) {
+      auto &vd = batch[k];
+      auto &c = candidates[k];
+      w.source_count[c.source]++;
+
+      if (c.source == FULL_RANDOM &&
+          FULL_RANDOM_SAMPLER == CROSS_ENTROPY_SAMPLER)
+        cem_update(w.cem, vd.decision, vd.value, player);
+
+      float gain = 0.0;
+      if (FINE_OPTIMIZE == OPTIMIZE_ALL) {
+        float value = vd.value;
+        vd = optimize_decision(player, state, vd, opt.table);
+        gain = vd.value - value;
+      }
+
+      elite_insert(w.elite, vd, ELITE_SIZE, player);
+      if (FINE_OPTIMIZE == OPTIMIZE_TOP_K)
+        elite_insert(w.top, vd, FINE_TOP_K, player);
+
+      if (vd.value > w.best_vd.value) {
+        w.best_vd = vd;
+        w.best_gain = gain;
+        // save suggestion or otherwise erase it
+        w.best_i = c.i;
+        w.best_suggestion = c.suggestion;
+        w.best_suggestion_i = c.suggestion_i;
+        w.best_source = c.source;
+
+        if (opt.anytime)
+          anytime_publish(*opt.anytime, worker, vd.value, vd.decision);
+      }
+    }
+
+    // check stop condition
+    w.count += count;
+    if (CONSTANT_RATE) {
+      if (steady_clock::now() >= deadline)
+        break;
+    } else if (i >= RAMIFICATION_NUMBER) {
+      break;
+    }
+  }
+}
+
+// refines every n_workers-th entry of top starting at worker, the ones left
+// when the deadline passes are kept as they are
+static void refine(ElitePool &top, int worker, int n_workers, Player player,
+                   const State &state, const DecisionTable &table,
+                   const GapField *field,
+                   std::chrono::steady_clock::time_point deadline) {
+  for (int k = worker; k < top.count; k += n_workers) {
+    if (CONSTANT_RATE && std::chrono::steady_clock::now() >= deadline)
+      break;
+    auto &vd = top.entries[k];
+    if (field) {
+      FOR_N(w, W_SIZE) vd.values[w] = 0.0;
+      vd.value = evaluate_with_decision(player, state, vd.decision, table,
+                                        vd.values);
+    }
+    vd = optimize_decision(player, state, vd, table);
+  }
+}
 
 ValuedDecision decide(Optimization &opt, State state, Player player,
                       Suggestions *suggestions, int *ramification_count) {
@@ -27,135 +262,211 @@ ValuedDecision decide(Optimization &opt, State state, Player player,
 
   opt.robot_to_move =
       ROBOT_WITH_PLAYER((opt.robot_to_move + 1) % N_ROBOTS, player);
-  bool kick = can_kick_directly(state, player);
+  // what every candidate would derive from the state alone
+  EvalContext ctx;
+  eval_context_init(ctx, state, player);
+
+  const auto now = steady_clock::now();
+  auto deadline = decision_deadline(now, opt.clock);
+  // the end of the slot is left to refine the best candidates
+  auto search_deadline = deadline;
+  if (FINE_OPTIMIZE == OPTIMIZE_TOP_K) {
+    int share = std::min(std::max(FINE_TOP_K_PERCENTAGE, 0), 100);
+    search_deadline = now + (deadline - now) * (100 - share) / 100;
+  }
 
-  ValuedDecision best_vd;
-  best_vd.value = -std::numeric_limits<float>::infinity();
+  // with a fixed number of ramifications the same seed replays this decide,
+  // with the cross-entropy sampler only if DECISION_THREADS is kept too
+  opt.seed = DECISION_SEED > 0 ? DECISION_SEED : rng_fresh_seed();
+
+  // sources left out by the bandit get no candidates; the group is read once
+  // so the update credits the one that allocated, even if it switches meanwhile
+  const int group = *PARAM_GROUP;
+  opt.allocation = bandit_allocate(opt.bandit, group);
+  if (!opt.allocation.suggestions)
+    suggestions = nullptr;
+
+  // replies start from the previous decision scored on this state, the table
+  // candidate as the search will draw it
+  if (opt.anytime) {
+    int n_suggestions = suggestions ? suggestions->tables_count : 0;
+    rng_seed(thread_rng(), opt.seed, n_suggestions);
+    Decision previous = from_decision_table(opt.table, ctx);
+    anytime_begin(*opt.anytime,
+                  evaluate_with_decision(player, state, previous, opt.table),
+                  previous);
+  }
 
-  const duration<double> max_delta{1.0 / DECISION_RATE};
-  const auto start = steady_clock::now();
+  // the table and suggestions are only read while searching, every worker
+  // has its own scratch decisions and random stream
+  int n_workers = std::min(std::max(DECISION_THREADS, 1), MAX_DECISION_THREADS);
+  if (opt.workers_count != n_workers) {
+    opt.workers.reset(new SearchWorker[n_workers]);
+    opt.workers_count = n_workers;
+  } else {
+    FOR_N(k, n_workers) { reset(opt.workers[k]); }
+  }
+  SearchWorker *workers = opt.workers.get();
+  std::thread threads[MAX_DECISION_THREADS];
+  // the elite of the previous decide is re-scored against this state
+  ElitePool seeds = opt.elite;
+  if (!opt.allocation.elite)
+    seeds.count = 0;
+
+  // the enemy goal seen from anywhere, built by every worker before searching
+  const GapField *field = nullptr;
+  if (GAP_FIELD) {
+    gap_field_resize(opt.field, ENEMY_FOR(player), GAP_FIELD_RESOLUTION);
+    FOR_RANGE(k, 1, n_workers) {
+      threads[k] =
+          std::thread(gap_field_fill, std::ref(opt.field), std::cref(state), k,
+                      n_workers);
+    }
+    gap_field_fill(opt.field, state, 0, n_workers);
+    FOR_RANGE(k, 1, n_workers) { threads[k].join(); }
+    field = &opt.field;
+  }
 
-  // this should point to a suggestion if one leads to the best decision
-  SuggestionTable *best_suggestion = nullptr;
-  int best_suggestion_i = -1;
-  DecisionSource best_source = NO_SOURCE;
+  FOR_RANGE(k, 1, n_workers) {
+    threads[k] = std::thread(search, std::ref(workers[k]), k, n_workers,
+                             std::ref(opt), std::cref(ctx), suggestions,
+                             std::cref(seeds), field, search_deadline);
+  }
+  search(workers[0], 0, n_workers, opt, ctx, suggestions, seeds, field,
+         search_deadline);
+  FOR_RANGE(k, 1, n_workers) { threads[k].join(); }
+
+  // reduce, on ties the earliest sample wins like on a sequential search
+  SearchWorker *best = &workers[0];
+  int count = workers[0].count;
+  opt.pruned_count = workers[0].pruned_count;
+  FOR_N(s, N_SOURCES) { opt.source_count[s] = workers[0].source_count[s]; }
+  FOR_RANGE(k, 1, n_workers) {
+    auto &w = workers[k];
+    count += w.count;
+    opt.pruned_count += w.pruned_count;
+    FOR_N(s, N_SOURCES) { opt.source_count[s] += w.source_count[s]; }
+    if (w.best_i < 0)
+      continue;
+    if (w.best_vd.value > best->best_vd.value ||
+        (w.best_vd.value == best->best_vd.value && w.best_i < best->best_i))
+      best = &w;
+  }
+  *ramification_count = count;
 
-  int i = 0;
-  while (true) {
-    // FOR_N(i, RAMIFICATION_NUMBER) {
-    Decision decision;
-    ValuedDecision vd;
-    DecisionSource source;
-    SuggestionTable *local_suggestion = nullptr;
-    int local_suggestion_i = -1;
-
-    // always consider the previous decision (based on the decision
-    // table)
-    // unless it's a kick action, those can only happen if kick
-    if (suggestions && i < suggestions->tables_count) {
-      local_suggestion = &suggestions->tables[i];
-      local_suggestion_i = i;
-      vd.decision =
-          gen_decision(kick, *local_suggestion, &state, opt.table, player);
-      source = SUGGESTION;
-    } else if (i == (suggestions ? suggestions->tables_count : 0)) {
-      vd.decision = from_decision_table(opt.table, state, player, kick);
-      source = TABLE;
-      // on some cases try to move everyone at once, this may lead to
-      // better
-      // results
-    } else if (100.0 * i / RAMIFICATION_NUMBER < FULL_CHANGE_PERCENTAGE) {
-      vd.decision = gen_decision(kick, state, player, opt.table);
-      source = FULL_RANDOM;
-      // on everything else roun-robin between trying to move each robot
-    } else {
-      vd.decision =
-          gen_decision(kick, state, player, opt.table, opt.robot_to_move);
-      source = SINGLE_RANDOM;
-    }
+  ValuedDecision best_vd = best->best_vd;
 
-    vd.value = evaluate_with_decision(player, state, vd.decision, opt.table,
-                                      vd.values);
+  // the field only approximates, the value kept is the exact one
+  if (field) {
+    FOR_N(w, W_SIZE) best_vd.values[w] = 0.0;
+    best_vd.value = evaluate_with_decision(player, state, best_vd.decision,
+                                           opt.table, best_vd.values);
+  }
 
-    if (FINE_OPTIMIZE == OPTIMIZE_ALL) {
-      vd = optimize_decision(player, state, vd, opt.table);
+  // optimize the best decision
+  opt.fine_gain = best->best_gain;
+  if (FINE_OPTIMIZE == OPTIMIZE_BEST) {
+    float value = best_vd.value;
+    best_vd = optimize_decision(player, state, best_vd, opt.table);
+    opt.fine_gain = best_vd.value - value;
+    if (opt.anytime)
+      anytime_publish(*opt.anytime, 0, best_vd.value, best_vd.decision);
+  } else if (FINE_OPTIMIZE == OPTIMIZE_TOP_K) {
+    // the best sample may not be on the best basin, the sources are still
+    // credited to it
+    ElitePool top;
+    FOR_N(k, n_workers) {
+      elite_merge(top, workers[k].top, FINE_TOP_K, player);
     }
-
-    if (vd.value > best_vd.value) {
-      best_vd = vd;
-      // best_vd.value = value;
-      // FOR_N(i, W_SIZE) best_vd.values[i] = values[i];
-      // memcpy(best_vd.values, values, W_SIZE * sizeof(*values));
-      // best_vd.decision = decision;
-      // save suggestion or otherwise erase it
-      best_suggestion = local_suggestion;
-      best_suggestion_i = local_suggestion_i;
-      best_source = source;
+    int n_refiners = std::min(n_workers, top.count);
+    FOR_RANGE(k, 1, n_refiners) {
+      threads[k] = std::thread(refine, std::ref(top), k, n_refiners, player,
+                               std::cref(state), std::cref(opt.table), field,
+                               deadline);
     }
+    refine(top, 0, n_refiners, player, state, opt.table, field, deadline);
+    FOR_RANGE(k, 1, n_refiners) { threads[k].join(); }
 
-    // check stop condition
-    i++;
-    if (CONSTANT_RATE) {
-      const auto now = steady_clock::now();
-      if (now - start >= max_delta)
-        break;
-    } else if (i >= RAMIFICATION_NUMBER) {
-      break;
+    float value = best_vd.value;
+    FOR_N(k, top.count) {
+      if (top.entries[k].value > best_vd.value)
+        best_vd = top.entries[k];
     }
+    opt.fine_gain = best_vd.value - value;
+    if (opt.anytime)
+      anytime_publish(*opt.anytime, 0, best_vd.value, best_vd.decision);
   }
-  *ramification_count = i;
 
-  // optimize the best decision
-  if (FINE_OPTIMIZE == OPTIMIZE_BEST) {
-    best_vd = optimize_decision(player, state, best_vd, opt.table);
+  // keep the best of this decide to seed the next one
+  opt.elite.count = 0;
+  FOR_N(k, n_workers) {
+    elite_merge(opt.elite, workers[k].elite, ELITE_SIZE, player);
   }
+  elite_insert(opt.elite, best_vd, ELITE_SIZE, player);
 
   // increment the usage count if decision from a suggestion
-  if (best_suggestion) {
-    best_suggestion->usage_count++;
-    suggestions->last_used = best_suggestion_i;
+  if (best->best_suggestion) {
+    best->best_suggestion->usage_count++;
+    suggestions->last_used = best->best_suggestion_i;
   }
 
-  *app_decision_source = best_source;
+  *app_decision_source = best->best_source;
+  bandit_update(opt.bandit, group, opt.source_count, best->best_source);
 
-  // update the decision table
-  opt.table.kick_robot = -1;
-  opt.table.pass_robot = -1;
-  FOR_TEAM_ROBOT(i, player) {
-    auto action = best_vd.decision.action[i];
-    switch (action.type) {
-    case KICK: {
-      opt.table.kick_robot = i;
-      opt.table.kick = action;
-    } break;
-    case PASS: {
-      opt.table.pass_robot = i;
-      opt.table.pass = action;
-    } break;
-    case MOVE: {
-      opt.table.move[i] = action;
-    } break;
-    case NONE:
-      break;
-    }
-  }
+  update_decision_table(opt.table, best_vd.decision, player);
 
   return best_vd;
 }
 
-float gap_value(const State state, Player player, Vector pos) {
-  Vector goal = GOAL_POS(player);
-  float dist_to_goal = dist(pos, goal);
+// a decide synced to packets gets at least this part of 1 / DECISION_RATE
+static constexpr double MIN_SYNCED_BUDGET = 0.5;
 
-  float total_gap_linear = total_gap_len_from_pos(state, pos, player);
-  float total_gap = DEGREES(2 * atan2f(total_gap_linear / 2, dist_to_goal));
+std::chrono::steady_clock::time_point
+decision_deadline(std::chrono::steady_clock::time_point now,
+                  const PacketClock *clock) {
+  using namespace std::chrono;
+  const duration<double> max_delta{1.0 / DECISION_RATE};
+  auto deadline = now + duration_cast<steady_clock::duration>(max_delta);
+  if (SYNC_TO_PACKETS && clock)
+    packet_clock_deadline(*clock, now, deadline, PACKET_MARGIN,
+                          MIN_SYNCED_BUDGET * max_delta.count(), &deadline);
+  return deadline;
+}
+
+template <typename T>
+T gap_value(const BasicState<T> &state, Player player, BasicVector<T> pos) {
+  int gaps_count;
+  BasicSegment<T> gaps[2 * N_ROBOTS + 1];
+  discover_gaps_from_pos(state, pos, player, gaps, &gaps_count);
+  return gap_value_of_gaps(player, pos, gaps, gaps_count);
+}
+
+template float gap_value(const State &, Player, Vector);
+template Dual gap_value(const BasicState<Dual> &, Player, BasicVector<Dual>);
+
+template <typename T>
+T gap_value_of_gaps(Player player, BasicVector<T> pos,
+                    const BasicSegment<T> *gaps, int gaps_count) {
+  using std::atan2;
+  BasicVector<T> goal = GOAL_POS(player);
+  T dist_to_goal = dist(pos, goal);
+
+  // same as total_gap_len_from_pos and max_gap_len_from_pos
+  T total_gap_linear = 0.0, max_gap_linear = 0.0;
+  FOR_N(i, gaps_count) {
+    T len = gaps[i].u - gaps[i].d;
+    total_gap_linear += len;
+    if (len > max_gap_linear)
+      max_gap_linear = len;
+  }
+
+  T total_gap = DEGREES(2 * atan2(total_gap_linear / 2, dist_to_goal));
   while (total_gap < 0)
     total_gap += 360;
   while (total_gap > 360)
     total_gap -= 360;
 
-  float max_gap_linear = max_gap_len_from_pos(state, pos, player);
-  float max_gap = DEGREES(2 * atan2f(max_gap_linear / 2, dist_to_goal));
+  T max_gap = DEGREES(2 * atan2(max_gap_linear / 2, dist_to_goal));
   while (max_gap < 0)
     max_gap += 360;
   while (max_gap > 360)
@@ -164,113 +475,266 @@ float gap_value(const State state, Player player, Vector pos) {
   return TOTAL_MAX_GAP_RATIO * total_gap + (1 - TOTAL_MAX_GAP_RATIO) * max_gap;
 }
 
-float evaluate_with_decision(Player player, const State &state,
-                             const struct Decision &decision,
-                             const struct DecisionTable &table, float *values) {
-  State next_state = state;
-  apply_to_state(decision, player, &next_state);
+template float gap_value_of_gaps(Player, Vector, const Segment *, int);
+template Dual gap_value_of_gaps(Player, BasicVector<Dual>,
+                                const BasicSegment<Dual> *, int);
+
+// terms of the evaluation that are computed from the moved robot positions
+// alone, evaluate_batch() computes these for many candidates at once
+template <typename T> struct EvalTerms {
+  int rwb, rwb_player;
+  T time_player, time_enemy;
+  // only for MOVE actions, zero otherwise
+  TeamArray<T> move_dist;
+  T move_dist_total, move_dist_max;
+  TeamArray<bool> near_enemy_goal;
+};
+
+// a MOVE takes the robot to its target, the moved position stands for the
+// target so that on Dual the derivatives to it come along
+template <typename T>
+static void eval_terms(Player player, const State &state,
+                       const BasicState<T> &next_state,
+                       const Decision &decision, EvalTerms<T> &terms) {
+  T time_min, time_max;
+  int rwb_min, rwb_max;
 
-  float dumb_values[W_SIZE];
-  if (values == nullptr)
-    values = dumb_values;
+  terms.rwb =
+      robot_with_ball(next_state, &time_min, &time_max, &rwb_min, &rwb_max);
+  terms.time_player = player == MAX ? time_max : time_min;
+  terms.time_enemy = player == MIN ? time_max : time_min;
+  terms.rwb_player = player == MAX ? rwb_max : rwb_min;
 
+  terms.move_dist_total = 0;
+  terms.move_dist_max = 0;
   Player enemy = ENEMY_FOR(player);
 
-  float time_min, time_max;
-  int rwb_min, rwb_max;
-
-  // check whether we have the ball
-  int rwb =
-      robot_with_ball(next_state, &time_min, &time_max, &rwb_min, &rwb_max);
-  bool has_ball = PLAYER_OF(rwb) == player;
+  FOR_TEAM_ROBOT(i, player) {
+    auto action = decision.action[i];
+    T move_dist = 0;
+    if (action.type == MOVE) {
+      move_dist = norm(next_state.robots[i] - state.robots[i]);
+      terms.move_dist_max = std::max(terms.move_dist_max, move_dist);
+      terms.move_dist_total += move_dist;
+    }
+    terms.move_dist[i] = move_dist;
+    terms.near_enemy_goal[i] =
+        dist(value_of(next_state.robots[i]), GOAL_POS(enemy)) <
+        DIST_GOAL_TO_PENAL;
+  }
+}
 
-  float time_player = player == MAX ? time_max : time_min;
-  float time_enemy = player == MIN ? time_max : time_min;
-  int rwb_player = player == MAX ? rwb_max : rwb_min;
-  // int rwb_enemy = player == MIN ? rwb_max : rwb_min;
+// same as eval_terms for up to SIMD_WIDTH candidates, one on each lane; the
+// time of a robot that is where it is on the state in every lane comes from
+// the context, and with delta the same for its base position, as long as no
+// lane moved the ball
+static void eval_terms_lanes(const EvalContext &ctx, const State *next_states,
+                             const ValuedDecision *vds, int count,
+                             const DeltaEval *delta,
+                             EvalTerms<float> *terms) {
+  auto &state = *ctx.state;
+  Player player = ctx.player;
+  // structure of arrays of the moved positions, the unused lanes repeat the
+  // first candidate
+  float ball_x[SIMD_WIDTH], ball_y[SIMD_WIDTH], ball_vx[SIMD_WIDTH],
+      ball_vy[SIMD_WIDTH];
+  float robot_x[2 * N_ROBOTS][SIMD_WIDTH], robot_y[2 * N_ROBOTS][SIMD_WIDTH];
+  float move_x[N_ROBOTS][SIMD_WIDTH], move_y[N_ROBOTS][SIMD_WIDTH],
+      is_move[N_ROBOTS][SIMD_WIDTH];
+
+  int offset = player * N_ROBOTS;
+  FOR_N(k, SIMD_WIDTH) {
+    int c = k < count ? k : 0;
+    auto &next_state = next_states[c];
+    ball_x[k] = next_state.ball.x;
+    ball_y[k] = next_state.ball.y;
+    ball_vx[k] = next_state.ball_v.x;
+    ball_vy[k] = next_state.ball_v.y;
+    FOR_EVERY_ROBOT(i) {
+      robot_x[i][k] = next_state.robots[i].x;
+      robot_y[i][k] = next_state.robots[i].y;
+    }
+    FOR_TEAM_ROBOT(i, player) {
+      auto action = vds[c].decision.action[i];
+      bool move = action.type == MOVE;
+      move_x[i - offset][k] = move ? action.move_pos.x : 0;
+      move_y[i - offset][k] = move ? action.move_pos.y : 0;
+      is_move[i - offset][k] = move ? 1 : 0;
+    }
+  }
 
-  float value = 0.0;
-#define W(NAME, VAL)                                                           \
-  do {                                                                         \
-    float v = NAME * VAL;                                                      \
-    values[_##NAME] += v;                                                      \
-    value += v;                                                                \
-  } while (false)
+  const Floats zero = floats_set(0);
+  const Floats inf = floats_set(std::numeric_limits<float>::infinity());
+
+  // robot_with_ball: time_to_pos of every robot
+  Floats bx = floats_load(ball_x), by = floats_load(ball_y);
+  Floats bvx = floats_load(ball_vx), bvy = floats_load(ball_vy);
+  Floats a = floats_set(SQ(ROBOT_MAX_SPEED)) - (bvx * bvx + bvy * bvy);
+
+  Floats best_time = inf, best_time_min = inf, best_time_max = inf;
+  Floats robot = zero, robot_min = zero, robot_max = zero;
+
+  const int all_lanes = (1 << SIMD_WIDTH) - 1;
+  auto on_base = [&](Floats x, Floats y, Vector base) {
+    return mask_bits((x == floats_set(base.x)) & (y == floats_set(base.y))) ==
+           all_lanes;
+  };
+  bool ball_on_base = delta && on_base(bx, by, delta->base.ball) &&
+                      on_base(bvx, bvy, delta->base.ball_v);
+  bool ball_on_state =
+      on_base(bx, by, state.ball) && on_base(bvx, bvy, state.ball_v);
+
+  FOR_EVERY_ROBOT(i) {
+    Floats rx = floats_load(robot_x[i]), ry = floats_load(robot_y[i]);
+    Floats t;
+    if (ball_on_state && on_base(rx, ry, state.robots[i]))
+      t = floats_set(ctx.ball_time[i]);
+    else if (ball_on_base && on_base(rx, ry, delta->base.robots[i]))
+      t = floats_set(delta->ball_time[i]);
+    else
+      t = time_to_pos_lanes(rx, ry, bx, by, bvx, bvy, a);
+
+    Floats ri = floats_set(i);
+    Mask better = t < best_time;
+    best_time = select(better, t, best_time);
+    robot = select(better, ri, robot);
+    if (PLAYER_OF(i) == MIN) {
+      better = t < best_time_min;
+      best_time_min = select(better, t, best_time_min);
+      robot_min = select(better, ri, robot_min);
+    } else {
+      better = t < best_time_max;
+      best_time_max = select(better, t, best_time_max);
+      robot_max = select(better, ri, robot_max);
+    }
+  }
 
-  W(WEIGHT_CLOSE_TO_BALL, 1 / (1 + time_player));
-  W(WEIGHT_ENEMY_CLOSE_TO_BALL, -1 / (1 + time_enemy));
-  W(WEIGHT_BALL_POS, next_state.ball.x);
+  // move distances and distance to the enemy goal
+  Vector goal = GOAL_POS(ENEMY_FOR(player));
+  Floats dist_total = zero, dist_max = zero;
+  Floats move_dist[N_ROBOTS], goal_dist[N_ROBOTS];
 
-  // bonus for having the ball
-  if (has_ball) {
-    W(WEIGHT_HAS_BALL, 1);
+  FOR_TEAM_ROBOT(i, player) {
+    int j = i - offset;
+    Floats dx = floats_load(move_x[j]) - floats_set(state.robots[i].x);
+    Floats dy = floats_load(move_y[j]) - floats_set(state.robots[i].y);
+    Floats md = floats_sqrt(dx * dx + dy * dy);
+    md = select(floats_load(is_move[j]) != zero, md, zero);
+    dist_max = select(dist_max < md, md, dist_max);
+    dist_total = dist_total + md;
+    move_dist[j] = md;
+
+    Floats gx = floats_set(goal.x) - floats_load(robot_x[i]);
+    Floats gy = floats_set(goal.y) - floats_load(robot_y[i]);
+    goal_dist[j] = floats_sqrt(gx * gx + gy * gy);
   }
 
-  W(WEIGHT_ATTACK, gap_value(next_state, enemy, next_state.ball));
-  W(WEIGHT_BLOCK_ATTACKER, -gap_value(next_state, player, next_state.ball));
+  // back to one struct per candidate
+  float out_time_min[SIMD_WIDTH], out_time_max[SIMD_WIDTH];
+  float out_rwb[SIMD_WIDTH], out_rwb_min[SIMD_WIDTH], out_rwb_max[SIMD_WIDTH];
+  float out_total[SIMD_WIDTH], out_max[SIMD_WIDTH];
+  float out_move[N_ROBOTS][SIMD_WIDTH], out_goal[N_ROBOTS][SIMD_WIDTH];
+  floats_store(out_time_min, best_time_min);
+  floats_store(out_time_max, best_time_max);
+  floats_store(out_rwb, robot);
+  floats_store(out_rwb_min, robot_min);
+  floats_store(out_rwb_max, robot_max);
+  floats_store(out_total, dist_total);
+  floats_store(out_max, dist_max);
+  FOR_N(j, N_ROBOTS) {
+    floats_store(out_move[j], move_dist[j]);
+    floats_store(out_goal[j], goal_dist[j]);
+  }
 
-  // penalty for exposing own goal
-  FOR_TEAM_ROBOT(i, enemy) {
-    W(WEIGHT_BLOCK_GOAL, -gap_value(next_state, player, next_state.robots[i]));
+  FOR_N(k, count) {
+    auto &t = terms[k];
+    t.rwb = out_rwb[k];
+    t.time_player = player == MAX ? out_time_max[k] : out_time_min[k];
+    t.time_enemy = player == MIN ? out_time_max[k] : out_time_min[k];
+    t.rwb_player = player == MAX ? out_rwb_max[k] : out_rwb_min[k];
+    t.move_dist_total = out_total[k];
+    t.move_dist_max = out_max[k];
+    FOR_TEAM_ROBOT(i, player) {
+      t.move_dist[i] = out_move[i - offset][k];
+      t.near_enemy_goal[i] = out_goal[i - offset][k] < DIST_GOAL_TO_PENAL;
+    }
   }
+}
 
-  // bonus for having more robots able to receive a pass
-  TeamFilter receivers;
-  discover_possible_receivers(next_state, &table, player, receivers,
-                              has_ball ? rwb : -1);
-  W(WEIGHT_RECEIVERS_NUM, receivers.count);
+// largest value gap_value can give at pos, from the angle of the whole goal
+static void gap_value_range(Player player, Vector pos, float *lo, float *hi) {
+  float goal = DEGREES(2 * atan2f(GOAL_WIDTH / 2, dist(pos, GOAL_POS(player))));
+  float r = TOTAL_MAX_GAP_RATIO;
+  *lo = (std::min(r, 0.0f) + std::min(1 - r, 0.0f)) * goal;
+  *hi = (std::max(r, 0.0f) + std::max(1 - r, 0.0f)) * goal;
+}
 
-  // penalty for having enemies able to receive a pass
-  TeamFilter enemy_receivers;
-  discover_possible_receivers(next_state, &table, enemy, enemy_receivers,
-                              has_ball ? -1 : rwb);
-  W(WEIGHT_ENEMY_RECEIVERS_NUM, -enemy_receivers.count);
+// optimistic bound on the value of an evaluation, every term starts at the
+// top of its range and is replaced by its real value once computed
+struct Bound {
+  double value = 0.0;
+  // scale of the terms, for the rounding margin
+  double magnitude = 0.0;
 
-  // bonus for seeing enemy goal
-  float best_receiver = 0;
-  FOR_TEAM_ROBOT(i, player) {
-    float gap = gap_value(next_state, enemy, next_state.robots[i]);
-    auto robot = next_state.robots[i];
-    W(WEIGHT_SEE_ENEMY_GOAL, gap);
+  void known(float v) {
+    value += v;
+    magnitude += std::fabs(v);
+  }
 
-    if (rwb_player != i && !receivers[i] &&
-        norm2(robot - GOAL_POS(enemy)) > SQ(DEFENSE_RADIUS)) {
-      float this_gap = fmin(0.1, gap);
-      float good_receiver =
-          this_gap /
-          (1 + SQ(DESIRED_PASS_DIST - norm(next_state.ball - robot)));
-      good_receiver += robot.x + FIELD_WIDTH / 2;
-      if (best_receiver < good_receiver)
-        best_receiver = good_receiver;
-    }
+  // weight * x for x in [lo, hi], returns the top that was added
+  float unknown(float weight, float lo, float hi) {
+    float top = std::max(weight * lo, weight * hi);
+    value += top;
+    magnitude += std::max(std::fabs(weight * lo), std::fabs(weight * hi));
+    return top;
+  }
 
-    // penalty for being too close to enemy goal
-    if (dist(next_state.robots[i], GOAL_POS(enemy)) < DIST_GOAL_TO_PENAL) {
-      value -= DIST_GOAL_PENAL;
-      values[_WEIGHT_PENALS] -= DIST_GOAL_PENAL;
-    }
+  void replace(float top, float v) { value += (double)v - top; }
+
+  // the float sum may round differently from this one, the margin covers it
+  bool below(float cutoff) const {
+    return value + 1e-4 * magnitude + 1e-6 < cutoff;
   }
-  W(WEIGHT_GOOD_RECEIVERS, best_receiver);
+};
+
+// sums every weighted term, always in the same order so that the scalar and
+// the batched evaluation give the exact same value. Terms are computed from
+// the cheapest to the most expensive, if given a cutoff this stops and
+// returns -inf as soon as the value can't be above it. With delta the gaps
+// and receivers come from its caches, delta_begin must have been called on
+// next_state. With field the enemy goal seen by our robots is looked up on it,
+// inside the range gap_value has there so the bound still holds. On Dual
+// there's no cutoff, delta nor field, the derivatives come from the moved
+// positions as in eval_terms.
+template <typename T>
+static T combine(Player player, const State &state,
+                 const BasicState<T> &next_state, const Decision &decision,
+                 const DecisionTable &table, const EvalTerms<T> &terms,
+                 T *values, float cutoff, DeltaEval *delta,
+                 const GapField *field) {
+  Player enemy = ENEMY_FOR(player);
+  int rwb = terms.rwb;
+  bool has_ball = PLAYER_OF(rwb) == player;
+  bool prune = cutoff > -std::numeric_limits<float>::infinity();
 
-  float move_dist_total = 0, move_dist_max = 0, move_change = 0,
-        pass_change = 0, kick_change = 0;
+  T close_to_ball = 1 / (1 + terms.time_player);
+  T enemy_close_to_ball = -1 / (1 + terms.time_enemy);
+  T move_change = 0, pass_change = 0, kick_change = 0;
 
   FOR_TEAM_ROBOT(i, player) {
     auto action = decision.action[i];
     auto rpos = state.robots[i];
     switch (action.type) {
     case MOVE: {
-      float move_dist = norm(action.move_pos - rpos);
-      move_dist_max = std::max(move_dist_max, move_dist);
-      move_dist_total += move_dist;
+      T move_dist = terms.move_dist[i];
 
-      auto mvec = table.move[i].move_pos - rpos;
-      auto nvec = action.move_pos - rpos;
+      BasicVector<T> mvec = table.move[i].move_pos - rpos;
+      auto nvec = next_state.robots[i] - rpos;
       auto mnd = sqrt(norm2(mvec) * norm2(nvec));
       if (move_dist > ROBOT_RADIUS && mnd > SQ(ROBOT_RADIUS)) {
         // move_change += norm(action.move_pos -
         // table.move[i].move_pos);
-        float c = mvec * nvec / mnd;
+        T c = mvec * nvec / mnd;
         if (c - 1.0 < 0.00001)
           c = 1.0;
         move_change += acos(c);
@@ -280,8 +744,13 @@ float evaluate_with_decision(Player player, const State &state,
       if (table.pass_robot >= 0) {
         // XXX: assuming everything is ok and the receiver has a move
         // action
-        pass_change += norm(decision.action[action.pass_receiver].move_pos -
-                            table.move[table.pass.pass_receiver].move_pos);
+        int rcv = action.pass_receiver;
+        BasicVector<T> rcv_pos =
+            decision.action[rcv].type == MOVE
+                ? next_state.robots[rcv]
+                : BasicVector<T>(decision.action[rcv].move_pos);
+        pass_change +=
+            norm(rcv_pos - table.move[table.pass.pass_receiver].move_pos);
       }
       break;
     case KICK:
@@ -294,8 +763,174 @@ float evaluate_with_decision(Player player, const State &state,
     }
   }
 
-  W(WEIGHT_MOVE_DIST_TOTAL, -move_dist_total);
-  W(WEIGHT_MOVE_DIST_MAX, -move_dist_max);
+  // everything computed so far is cheap, bound the rest
+  Bound bound;
+  float lo, hi;
+  float top_attack = 0, top_block_attacker = 0, top_receivers = 0,
+        top_enemy_receivers = 0, top_good_receivers = 0;
+  TeamArray<float> top_block_goal, top_see_enemy_goal;
+
+  if (prune) {
+    bound.known(value_of(WEIGHT_CLOSE_TO_BALL * close_to_ball));
+    bound.known(value_of(WEIGHT_ENEMY_CLOSE_TO_BALL * enemy_close_to_ball));
+    bound.known(value_of(WEIGHT_BALL_POS * next_state.ball.x));
+    if (has_ball)
+      bound.known(WEIGHT_HAS_BALL * 1);
+    bound.known(value_of(WEIGHT_MOVE_DIST_TOTAL * -terms.move_dist_total));
+    bound.known(value_of(WEIGHT_MOVE_DIST_MAX * -terms.move_dist_max));
+    bound.known(value_of(WEIGHT_MOVE_CHANGE * -move_change));
+    bound.known(value_of(WEIGHT_PASS_CHANGE * -pass_change));
+    bound.known(value_of(WEIGHT_KICK_CHANGE * -kick_change));
+
+    float best_x = 0;
+    FOR_TEAM_ROBOT(i, player) {
+      Vector robot = value_of(next_state.robots[i]);
+      if (terms.near_enemy_goal[i])
+        bound.known(-DIST_GOAL_PENAL);
+      gap_value_range(enemy, robot, &lo, &hi);
+      top_see_enemy_goal[i] = bound.unknown(WEIGHT_SEE_ENEMY_GOAL, lo, hi);
+      best_x = std::max(best_x, robot.x + FIELD_WIDTH / 2);
+    }
+    // good_receiver is at most 0.1 above the robot x
+    top_good_receivers =
+        bound.unknown(WEIGHT_GOOD_RECEIVERS, 0, best_x + 0.1f);
+
+    top_receivers = bound.unknown(WEIGHT_RECEIVERS_NUM, 0, N_ROBOTS);
+    top_enemy_receivers =
+        bound.unknown(WEIGHT_ENEMY_RECEIVERS_NUM, -N_ROBOTS, 0);
+
+    gap_value_range(enemy, value_of(next_state.ball), &lo, &hi);
+    top_attack = bound.unknown(WEIGHT_ATTACK, lo, hi);
+    gap_value_range(player, value_of(next_state.ball), &lo, &hi);
+    top_block_attacker = bound.unknown(WEIGHT_BLOCK_ATTACKER, -hi, -lo);
+    FOR_TEAM_ROBOT(i, enemy) {
+      gap_value_range(player, value_of(next_state.robots[i]), &lo, &hi);
+      top_block_goal[i] = bound.unknown(WEIGHT_BLOCK_GOAL, -hi, -lo);
+    }
+  }
+
+#define PRUNE_IF_BELOW(TOP, NAME, VAL)                                         \
+  do {                                                                         \
+    if (prune) {                                                               \
+      bound.replace(TOP, value_of(NAME * VAL));                                \
+      if (bound.below(cutoff))                                                 \
+        return -std::numeric_limits<float>::infinity();                        \
+    }                                                                          \
+  } while (false)
+
+  if (prune && bound.below(cutoff))
+    return -std::numeric_limits<float>::infinity();
+
+#define GAP_VALUE(GOAL_PLAYER, ROBOT)                                          \
+  (delta ? T(delta_gap_value(*delta, GOAL_PLAYER, ROBOT))                      \
+         : gap_value(next_state, GOAL_PLAYER,                                  \
+                     ROBOT >= 0 ? next_state.robots[ROBOT] : next_state.ball))
+
+  // receivers of both players share the ball
+  TeamFilter all_receivers[2];
+  int passers[2];
+  passers[player] = has_ball ? rwb : -1;
+  passers[enemy] = has_ball ? -1 : rwb;
+  if (delta)
+    delta_receivers(*delta, all_receivers, passers);
+  else
+    discover_possible_receivers(value_of(next_state), &table, all_receivers,
+                                passers);
+
+  // bonus for having more robots able to receive a pass
+  auto &receivers = all_receivers[player];
+  int receivers_num = receivers.count;
+  PRUNE_IF_BELOW(top_receivers, WEIGHT_RECEIVERS_NUM, receivers_num);
+
+  // penalty for having enemies able to receive a pass
+  auto &enemy_receivers = all_receivers[enemy];
+  int enemy_receivers_num = -enemy_receivers.count;
+  PRUNE_IF_BELOW(top_enemy_receivers, WEIGHT_ENEMY_RECEIVERS_NUM,
+                 enemy_receivers_num);
+
+  T attack = GAP_VALUE(enemy, -1);
+  PRUNE_IF_BELOW(top_attack, WEIGHT_ATTACK, attack);
+
+  T block_attacker = -GAP_VALUE(player, -1);
+  PRUNE_IF_BELOW(top_block_attacker, WEIGHT_BLOCK_ATTACKER, block_attacker);
+
+  // penalty for exposing own goal
+  TeamArray<T> block_goal;
+  FOR_TEAM_ROBOT(i, enemy) {
+    block_goal[i] = -GAP_VALUE(player, i);
+    PRUNE_IF_BELOW(top_block_goal[i], WEIGHT_BLOCK_GOAL, block_goal[i]);
+  }
+
+  // bonus for seeing enemy goal
+  TeamArray<T> see_enemy_goal;
+  T best_receiver = 0;
+  FOR_TEAM_ROBOT(i, player) {
+    auto robot = next_state.robots[i];
+    T gap;
+    if (field) {
+      Vector pos = value_of(robot);
+      gap_value_range(enemy, pos, &lo, &hi);
+      gap = std::min(std::max(gap_field_lookup(*field, pos), lo), hi);
+    } else {
+      gap = GAP_VALUE(enemy, i);
+    }
+    see_enemy_goal[i] = gap;
+    PRUNE_IF_BELOW(top_see_enemy_goal[i], WEIGHT_SEE_ENEMY_GOAL, gap);
+
+    if (terms.rwb_player != i && !receivers[i] &&
+        norm2(robot - GOAL_POS(enemy)) > SQ(DEFENSE_RADIUS)) {
+      T this_gap = fmin(0.1, gap);
+      T good_receiver =
+          this_gap /
+          (1 + SQ(DESIRED_PASS_DIST - norm(next_state.ball - robot)));
+      good_receiver += robot.x + FIELD_WIDTH / 2;
+      if (best_receiver < good_receiver)
+        best_receiver = good_receiver;
+    }
+  }
+  PRUNE_IF_BELOW(top_good_receivers, WEIGHT_GOOD_RECEIVERS, best_receiver);
+
+#undef PRUNE_IF_BELOW
+#undef GAP_VALUE
+
+  T value = 0.0;
+#define W(NAME, VAL)                                                           \
+  do {                                                                         \
+    T v = NAME * VAL;                                                      \
+    values[_##NAME] += v;                                                      \
+    value += v;                                                                \
+  } while (false)
+
+  W(WEIGHT_CLOSE_TO_BALL, close_to_ball);
+  W(WEIGHT_ENEMY_CLOSE_TO_BALL, enemy_close_to_ball);
+  W(WEIGHT_BALL_POS, next_state.ball.x);
+
+  // bonus for having the ball
+  if (has_ball) {
+    W(WEIGHT_HAS_BALL, 1);
+  }
+
+  W(WEIGHT_ATTACK, attack);
+  W(WEIGHT_BLOCK_ATTACKER, block_attacker);
+
+  FOR_TEAM_ROBOT(i, enemy) { W(WEIGHT_BLOCK_GOAL, block_goal[i]); }
+
+  W(WEIGHT_RECEIVERS_NUM, receivers_num);
+  W(WEIGHT_ENEMY_RECEIVERS_NUM, enemy_receivers_num);
+
+  FOR_TEAM_ROBOT(i, player) {
+    W(WEIGHT_SEE_ENEMY_GOAL, see_enemy_goal[i]);
+
+    // penalty for being too close to enemy goal
+    if (terms.near_enemy_goal[i]) {
+      value -= DIST_GOAL_PENAL;
+      values[_WEIGHT_PENALS] -= DIST_GOAL_PENAL;
+    }
+  }
+  W(WEIGHT_GOOD_RECEIVERS, best_receiver);
+
+  W(WEIGHT_MOVE_DIST_TOTAL, -terms.move_dist_total);
+  W(WEIGHT_MOVE_DIST_MAX, -terms.move_dist_max);
   W(WEIGHT_MOVE_CHANGE, -move_change);
   W(WEIGHT_PASS_CHANGE, -pass_change);
   W(WEIGHT_KICK_CHANGE, -kick_change);
@@ -304,9 +939,107 @@ float evaluate_with_decision(Player player, const State &state,
   return value;
 }
 
+float evaluate_with_decision(Player player, const State &state,
+                             const struct Decision &decision,
+                             const struct DecisionTable &table, float *values,
+                             float cutoff) {
+  State next_state = state;
+  apply_to_state(decision, player, &next_state);
+
+  float dumb_values[W_SIZE];
+  if (values == nullptr)
+    values = dumb_values;
+
+  EvalTerms<float> terms;
+  eval_terms(player, state, next_state, decision, terms);
+  return combine(player, state, next_state, decision, table, terms, values,
+                 cutoff, nullptr, nullptr);
+}
+
+int evaluate_batch(const EvalContext &ctx, ValuedDecision *vds, int count,
+                   const DecisionTable &table, const float *cutoffs,
+                   DeltaEval *delta, const GapField *field) {
+  auto &state = *ctx.state;
+  Player player = ctx.player;
+  State next_states[MAX_EVAL_BATCH];
+  EvalTerms<float> terms[MAX_EVAL_BATCH];
+
+  FOR_N(k, count) {
+    next_states[k] = state;
+    apply_to_state(vds[k].decision, player, &next_states[k]);
+  }
+
+  for (int k = 0; k < count; k += SIMD_WIDTH) {
+    eval_terms_lanes(ctx, next_states + k, vds + k,
+                     std::min(SIMD_WIDTH, count - k), delta, terms + k);
+  }
+
+  int pruned = 0;
+  FOR_N(k, count) {
+    auto &vd = vds[k];
+    float cutoff =
+        cutoffs ? cutoffs[k] : -std::numeric_limits<float>::infinity();
+    FOR_N(w, W_SIZE) vd.values[w] = 0.0;
+    if (delta)
+      delta_begin(*delta, next_states[k]);
+    vd.value = combine(player, state, next_states[k], vd.decision, table,
+                       terms[k], vd.values, cutoff, delta, field);
+    if (vd.value == -std::numeric_limits<float>::infinity())
+      pruned++;
+  }
+  return pruned;
+}
+
+float evaluate_with_decision_derivative(Player player, const State &state,
+                                        const Decision &decision,
+                                        const DecisionTable &table,
+                                        const TeamArray<Vector> &direction,
+                                        float *derivative) {
+  // as apply_to_state, with the move targets carrying the direction
+  BasicState<Dual> next_state = dual_state(state);
+  FOR_TEAM_ROBOT(i, player) {
+    auto action = decision.action[i];
+    if (action.type == MOVE)
+      next_state.robots[i] = {Dual(action.move_pos.x, direction[i].x),
+                              Dual(action.move_pos.y, direction[i].y)};
+  }
+  FOR_TEAM_ROBOT(i, player) {
+    if (decision.action[i].type != MOVE)
+      apply_to_state(decision.action[i], i, &next_state);
+  }
+
+  Dual values[W_SIZE];
+  EvalTerms<Dual> terms;
+  eval_terms(player, state, next_state, decision, terms);
+  Dual value = combine(player, state, next_state, decision, table, terms,
+                       values, -std::numeric_limits<float>::infinity(),
+                       nullptr, nullptr);
+  *derivative = value.der;
+  return value.val;
+}
+
 Gradient evaluate_with_decision_gradient(Player player, const State &state,
                                          const Decision &decision,
                                          const DecisionTable &table) {
+  if (ANALYTIC_GRADIENT)
+    return analytic_gradient(player, state, decision, table);
+
+  if (DUAL_GRADIENT) {
+    Gradient grad;
+    FOR_TEAM_ROBOT(i, player) {
+      if (decision.action[i].type != MOVE)
+        continue;
+
+      TeamArray<Vector> direction;
+      direction[i] = Vector(1, 0);
+      evaluate_with_decision_derivative(player, state, decision, table,
+                                        direction, &grad.deltas[i].x);
+      direction[i] = Vector(0, 1);
+      evaluate_with_decision_derivative(player, state, decision, table,
+                                        direction, &grad.deltas[i].y);
+    }
+    return grad;
+  }
 
   static constexpr float EPSILON =
       std::numeric_limits<float>::epsilon() * FIELD_WIDTH;
@@ -354,47 +1087,267 @@ Gradient evaluate_with_decision_gradient(Player player, const State &state,
   return grad;
 }
 
-ValuedDecision optimize_decision(Player player, const State &state,
-                                 const ValuedDecision &valued_decision,
-                                 const DecisionTable &table) {
+// the first step of the line search moves the targets this far
+static constexpr float FINE_STEP = 0.5; // 50cm
+// fraction of the gain the gradient predicts a step must get to be accepted
+static constexpr float ARMIJO_C = 1e-4;
+// adam moves each coordinate about FINE_ADAM_RATE times the accepted step
+static constexpr float FINE_ADAM_RATE = 0.5;
+static constexpr float ADAM_BETA1 = 0.9;
+static constexpr float ADAM_BETA2 = 0.999;
+static constexpr float ADAM_EPSILON = 1e-8;
+// the hessian is taken from gradients this far apart
+static constexpr float NEWTON_DELTA = 0.01; // 1cm
+
+// a pass of evaluate_with_decision_derivative takes about as long as this
+// many evaluations, the gaps can't be taken from the SIMD lanes
+static constexpr int DUAL_PASS_COST = 5;
+
+// evaluations a gradient takes from FINE_OPTIMIZE_BUDGET
+static int gradient_cost(void) {
+  if (ANALYTIC_GRADIENT)
+    return 1;
+  return DUAL_GRADIENT ? 2 * N_ROBOTS * DUAL_PASS_COST : 4 * N_ROBOTS;
+}
 
-#if 1
-  // Gradient descent (sort of)
-  Gradient grad = evaluate_with_decision_gradient(
-      player, state, valued_decision.decision, table);
+// to is from with every MOVE target moved by deltas * alpha, projected back
+// to where they are allowed, evaluated
+static void fine_step(Player player, const State &state,
+                      const DecisionTable &table, const ValuedDecision &from,
+                      const TeamArray<Vector> &deltas, float alpha,
+                      ValuedDecision &to) {
+  to.decision = from.decision;
+  FOR_TEAM_ROBOT(i, player) {
+    auto &action = to.decision.action[i];
+    if (action.type == MOVE)
+      action.move_pos += deltas[i] * alpha;
+  }
+  project_moves(to.decision, player, state, table);
+  FOR_N(w, W_SIZE) to.values[w] = 0.0;
+  to.value =
+      evaluate_with_decision(player, state, to.decision, table, to.values);
+}
 
-  ValuedDecision opt_vd;
-  static constexpr int MAX_IT = 16;
-  static constexpr float GAMMA = 0.4e-4;
-  float gamma = GAMMA;
+// backtracks alpha along dir until the gain is close enough to what the
+// slope (derivative of the value along dir) predicts, a step short of that
+// may still be the best seen; false if the budget ends first
+static bool armijo(Player player, const State &state,
+                   const DecisionTable &table, const ValuedDecision &from,
+                   const TeamArray<Vector> &dir, float slope, float &alpha,
+                   int &budget, ValuedDecision &to, ValuedDecision &best_vd) {
+  while (budget > 0) {
+    fine_step(player, state, table, from, dir, alpha, to);
+    budget--;
+    if (to.value > best_vd.value)
+      best_vd = to;
+    if (to.value >= from.value + ARMIJO_C * alpha * slope)
+      return true;
+    alpha /= 2;
+  }
+  return false;
+}
 
-  FOR_N(i, MAX_IT) {
-    opt_vd = valued_decision;
+// the move targets of a team as a single vector for the solvers, x and y of
+// each robot side by side
+using FineVector = numerical_method::vec<2 * N_ROBOTS>;
 
-    // add gamma * grad to opt_vd
-    FOR_TEAM_ROBOT(j, player) {
-      auto &action = opt_vd.decision.action[j];
-      if (action.type == MOVE) {
-        action.move_pos += grad.deltas[j] * gamma;
-      }
-    }
+static FineVector to_fine(const TeamArray<Vector> &deltas, Player player) {
+  FineVector x;
+  FOR_TEAM_ROBOT(i, player) {
+    x(2 * (i % N_ROBOTS)) = deltas[i].x;
+    x(2 * (i % N_ROBOTS) + 1) = deltas[i].y;
+  }
+  return x;
+}
 
-    opt_vd.value = evaluate_with_decision(player, state, opt_vd.decision, table,
-                                          opt_vd.values);
+// how far the move targets went from a to b
+static FineVector fine_delta(const Decision &a, const Decision &b,
+                               Player player) {
+  TeamArray<Vector> deltas;
+  FOR_TEAM_ROBOT(i, player) {
+    if (a.action[i].type == MOVE && b.action[i].type == MOVE)
+      deltas[i] = b.action[i].move_pos - a.action[i].move_pos;
+  }
+  return to_fine(deltas, player);
+}
 
-    if (opt_vd.value > valued_decision.value) {
-      goto optimized;
+static TeamArray<Vector> from_fine(const FineVector &x, Player player) {
+  TeamArray<Vector> deltas;
+  FOR_TEAM_ROBOT(i, player) {
+    deltas[i] = Vector(x(2 * (i % N_ROBOTS)), x(2 * (i % N_ROBOTS) + 1));
+  }
+  return deltas;
+}
+
+// line search then adam steps from there, scaled by the accepted step
+static void optimize_adam(Player player, const State &state,
+                          const DecisionTable &table, ValuedDecision vd,
+                          Gradient grad, float norm, int budget,
+                          ValuedDecision &best_vd) {
+  ValuedDecision trial;
+  float alpha = FINE_STEP / norm;
+  if (!armijo(player, state, table, vd, grad.deltas, norm * norm, alpha,
+              budget, trial, best_vd))
+    return;
+  vd = trial;
+
+  TeamArray<Vector> m, v, deltas;
+  float rate = FINE_ADAM_RATE * alpha * norm;
+  float beta1_t = 1.0, beta2_t = 1.0;
+  while (budget > gradient_cost()) {
+    grad = evaluate_with_decision_gradient(player, state, vd.decision, table);
+    budget -= gradient_cost();
+    beta1_t *= ADAM_BETA1;
+    beta2_t *= ADAM_BETA2;
+    FOR_TEAM_ROBOT(i, player) {
+      Vector g = grad.deltas[i];
+      m[i] = m[i] * ADAM_BETA1 + g * (1 - ADAM_BETA1);
+      Vector g2(g.x * g.x, g.y * g.y);
+      v[i] = v[i] * ADAM_BETA2 + g2 * (1 - ADAM_BETA2);
+      Vector m_hat = m[i] * (1 / (1 - beta1_t));
+      Vector v_hat = v[i] * (1 / (1 - beta2_t));
+      deltas[i] = Vector(m_hat.x / (std::sqrt(v_hat.x) + ADAM_EPSILON),
+                         m_hat.y / (std::sqrt(v_hat.y) + ADAM_EPSILON));
     }
+    fine_step(player, state, table, vd, deltas, rate, trial);
+    budget--;
+    vd = trial;
+    if (vd.value > best_vd.value)
+      best_vd = vd;
+  }
+}
 
-    gamma /= 2;
+// newton steps on a hessian from differences of the gradient, shifted until
+// the step goes up; a gradient step when the budget can't pay for a hessian
+static void optimize_newton(Player player, const State &state,
+                            const DecisionTable &table, ValuedDecision vd,
+                            Gradient grad, int budget,
+                            ValuedDecision &best_vd) {
+  bool active[2 * N_ROBOTS] = {};
+  int n_active = 0;
+  FOR_TEAM_ROBOT(i, player) {
+    bool move = vd.decision.action[i].type == MOVE;
+    active[2 * (i % N_ROBOTS)] = active[2 * (i % N_ROBOTS) + 1] = move;
+    n_active += move ? 2 : 0;
   }
+  int hessian_cost = 2 * n_active * gradient_cost();
+
+  ValuedDecision trial;
+  while (budget > 0) {
+    FineVector g = to_fine(grad.deltas, player), p = g;
+    if (budget > hessian_cost) {
+      // gradient of the value with the targets of vd moved by dx
+      auto grad_at = [&](const FineVector &dx) {
+        Decision decision = vd.decision;
+        auto deltas = from_fine(dx, player);
+        FOR_TEAM_ROBOT(i, player) {
+          auto &action = decision.action[i];
+          if (action.type == MOVE)
+            action.move_pos += deltas[i];
+        }
+        return to_fine(evaluate_with_decision_gradient(player, state,
+                                                       decision, table)
+                           .deltas,
+                       player);
+      };
+      numerical_method::mat<2 * N_ROBOTS> H;
+      numerical_method::num eig_min, eig_max;
+      std::tie(H, eig_min, eig_max) = numerical_method::hessian_of_grad(
+          grad_at, FineVector(), NEWTON_DELTA, active);
+      budget -= hessian_cost;
+      // the value goes up, so the newton step is the one minimizing -value,
+      // without one the gradient is kept
+      FineVector step;
+      if (numerical_method::newton_direction(-1.0 * H, -1.0 * g, step))
+        p = step;
+    }
 
-  opt_vd = valued_decision;
-  gamma = -1;
+    float slope = numerical_method::inner_prod(g, p);
+    float length = numerical_method::norm(p);
+    if (!(slope > 0.0) || !(length > 0.0))
+      break;
+    float alpha = std::min(1.0f, FINE_STEP / length);
+    if (!armijo(player, state, table, vd, from_fine(p, player), slope, alpha,
+                budget, trial, best_vd))
+      break;
+    vd = trial;
 
-optimized:
-  printf("gamma = %g\n", gamma);
+    if (budget <= gradient_cost())
+      break;
+    grad = evaluate_with_decision_gradient(player, state, vd.decision, table);
+    budget -= gradient_cost();
+  }
+}
 
-  return opt_vd;
-#endif
+// quasi-newton steps, the inverse hessian is built up by bfgs updates from
+// the gradients of the steps taken, starting as a FINE_STEP long gradient step
+static void optimize_bfgs(Player player, const State &state,
+                          const DecisionTable &table, ValuedDecision vd,
+                          Gradient grad, float norm, int budget,
+                          ValuedDecision &best_vd) {
+  // of -value, which goes down
+  auto H_inv = numerical_method::identity<2 * N_ROBOTS>(FINE_STEP / norm);
+  FineVector g = to_fine(grad.deltas, player);
+
+  ValuedDecision trial;
+  while (budget > 0) {
+    FineVector p = H_inv * g;
+    float slope = numerical_method::inner_prod(g, p);
+    float length = numerical_method::norm(p);
+    if (!(slope > 0.0) || !(length > 0.0))
+      break;
+    float alpha = std::min(1.0f, FINE_STEP / length);
+    if (!armijo(player, state, table, vd, from_fine(p, player), slope, alpha,
+                budget, trial, best_vd))
+      break;
+    // the projection may have cut the step short
+    FineVector s = fine_delta(vd.decision, trial.decision, player);
+    vd = trial;
+
+    if (budget <= gradient_cost())
+      break;
+    grad = evaluate_with_decision_gradient(player, state, vd.decision, table);
+    budget -= gradient_cost();
+    FineVector g_next = to_fine(grad.deltas, player);
+    numerical_method::bfgs_update(H_inv, s, g - g_next);
+    g = g_next;
+  }
+}
+
+ValuedDecision optimize_decision(Player player, const State &state,
+                                 const ValuedDecision &valued_decision,
+                                 const DecisionTable &table) {
+  ValuedDecision best_vd = valued_decision;
+  int budget = FINE_OPTIMIZE_BUDGET - gradient_cost();
+  if (budget <= 0)
+    return best_vd;
+
+  Gradient grad = evaluate_with_decision_gradient(
+      player, state, valued_decision.decision, table);
+
+  float norm2 = 0.0;
+  FOR_TEAM_ROBOT(i, player) {
+    if (valued_decision.decision.action[i].type == MOVE)
+      norm2 += grad.deltas[i] * grad.deltas[i];
+  }
+  if (!(norm2 > 0.0))
+    return best_vd;
+  float norm = std::sqrt(norm2);
+
+  switch (FINE_METHOD) {
+  case FINE_ADAM:
+    optimize_adam(player, state, table, valued_decision, grad, norm, budget,
+                  best_vd);
+    break;
+  case FINE_NEWTON:
+    optimize_newton(player, state, table, valued_decision, grad, budget,
+                    best_vd);
+    break;
+  case FINE_BFGS:
+    optimize_bfgs(player, state, table, valued_decision, grad, norm, budget,
+                  best_vd);
+    break;
+  }
+
+  return best_vd;
 }
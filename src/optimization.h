@@ -1,31 +1,108 @@
 #ifndef OPTIMIZATION_H
 #define OPTIMIZATION_H
 
+#include <stdint.h>
+#include <limits>
+#include <chrono>
+#include <memory>
+
 #include "valued_decision.h"
 #include "decision_table.h"
 #include "state.h"
 #include "player.h"
 #include "consts.h"
 #include "gradient.h"
+#include "elite.h"
+#include "bandit.h"
+#include "gap_field.h"
 
 struct Optimization {
   DecisionTable table;
   int robot_to_move = 0;
   bool table_initialized = false;
+  // best distinct decisions of the previous decide, used as seeds
+  ElitePool elite;
+  // if set every improvement found while searching is published here
+  struct AnytimeDecision *anytime = nullptr;
+  // if set and SYNC_TO_PACKETS the search ends right before the next packet
+  struct PacketClock *clock = nullptr;
+  // seed of the last decide, candidate i is drawn from stream i
+  uint32_t seed = 0;
+  // evaluations of the last decide cut short by PRUNE_EVALUATION
+  int pruned_count = 0;
+  // value optimize_decision added to the decisions of the last decide
+  float fine_gain = 0.0;
+  // how candidates are spread between the decision sources
+  SourceBandit bandit;
+  Allocation allocation;
+  // candidates each source got on the last decide
+  int source_count[N_SOURCES] = {};
+  // used by the last decide if GAP_FIELD
+  GapField field;
+  // state of each search thread, kept on the heap since they are too big for
+  // the stack of the thread deciding
+  std::unique_ptr<struct SearchWorker[]> workers;
+  int workers_count = 0;
+
+  Optimization();
+  ~Optimization();
 };
 
 ValuedDecision decide(Optimization &opt, State state, Player player,
                       struct Suggestions *suggestions, int *ramification_count);
 
-float evaluate_with_decision(Player player, const State &state,
-                             const Decision &decision,
-                             const DecisionTable &table,
-                             float *values = nullptr);
+// when a decision started at now must be done, 1 / DECISION_RATE later or,
+// with SYNC_TO_PACKETS and a clock, right before the last packet by then
+std::chrono::steady_clock::time_point
+decision_deadline(std::chrono::steady_clock::time_point now,
+                  const struct PacketClock *clock);
+
+// if the value can't be above cutoff the evaluation stops early, returning
+// -inf and leaving values incomplete
+float evaluate_with_decision(
+    Player player, const State &state, const Decision &decision,
+    const DecisionTable &table, float *values = nullptr,
+    float cutoff = -std::numeric_limits<float>::infinity());
+
+// evaluates count (up to MAX_EVAL_BATCH) decisions against the state of ctx,
+// writing each value and values; gives the same results as calling
+// evaluate_with_decision on each of them, returns how many were cut short;
+// delta, if given, must have been initialized with the same state and table;
+// with field the values are approximated, see gap_field.h
+int evaluate_batch(const struct EvalContext &ctx, struct ValuedDecision *vds,
+                   int count, const DecisionTable &table,
+                   const float *cutoffs = nullptr,
+                   struct DeltaEval *delta = nullptr,
+                   const GapField *field = nullptr);
+
+// evaluate_with_decision with no cutoff, and its exact derivative along
+// direction, a velocity for the target of each MOVE, in a single pass on Dual;
+// the value may differ from the float one by rounding
+float evaluate_with_decision_derivative(Player player, const State &state,
+                                        const Decision &decision,
+                                        const DecisionTable &table,
+                                        const TeamArray<Vector> &direction,
+                                        float *derivative);
+
+// instantiated for float and Dual
+template <typename T>
+T gap_value(const BasicState<T> &state, Player player, BasicVector<T> pos);
+
+// gap_value from the gaps discover_gaps_from_pos found at pos
+template <typename T>
+T gap_value_of_gaps(Player player, BasicVector<T> pos,
+                    const BasicSegment<T> *gaps, int gaps_count);
 
+// analytic_gradient if ANALYTIC_GRADIENT, a pass of
+// evaluate_with_decision_derivative per coordinate if DUAL_GRADIENT, central
+// differences otherwise
 Gradient evaluate_with_decision_gradient(Player player, const State &state,
                                          const Decision &decision,
                                          const DecisionTable &table);
 
+// climbs from valued_decision with FINE_METHOD, within FINE_OPTIMIZE_BUDGET
+// evaluations; returns the best decision seen, never worse than
+// valued_decision
 ValuedDecision optimize_decision(Player player, const State &state,
                                  const ValuedDecision &valued_decision,
                                  const DecisionTable &table);
@@ -0,0 +1,68 @@
+#include "packet_clock.h"
+
+using namespace std::chrono;
+
+// weight of the newest interval on the period
+static constexpr double PERIOD_SMOOTHING = 0.1;
+// intervals longer than this many periods had a packet lost
+static constexpr double MAX_INTERVAL_PERIODS = 1.5;
+// nothing is predicted after this many periods without a packet
+static constexpr long long MAX_SILENT_PERIODS = 10;
+// after this many intervals in a row left out the period starts over from
+// the shortest of them
+static constexpr int MAX_REJECTED = 3;
+
+static long long ticks(float seconds) {
+  return duration_cast<steady_clock::duration>(duration<double>(seconds))
+      .count();
+}
+
+void packet_clock_mark(PacketClock &clock, steady_clock::time_point arrival) {
+  long long t = arrival.time_since_epoch().count();
+  long long last = clock.last.exchange(t, std::memory_order_relaxed);
+  if (last == 0)
+    return;
+
+  long long interval = t - last;
+  long long period = clock.period.load(std::memory_order_relaxed);
+  if (period == 0) {
+    period = interval;
+  } else if (interval <= MAX_INTERVAL_PERIODS * period) {
+    period += (long long)(PERIOD_SMOOTHING * (interval - period));
+  } else {
+    if (clock.rejected == 0 || interval < clock.rejected_min)
+      clock.rejected_min = interval;
+    if (++clock.rejected < MAX_REJECTED)
+      return;
+    period = clock.rejected_min;
+  }
+  clock.rejected = 0;
+  clock.period.store(period, std::memory_order_relaxed);
+}
+
+bool packet_clock_deadline(const PacketClock &clock,
+                           steady_clock::time_point now,
+                           steady_clock::time_point limit, float margin,
+                           float min_budget,
+                           steady_clock::time_point *deadline) {
+  long long last = clock.last.load(std::memory_order_relaxed);
+  long long period = clock.period.load(std::memory_order_relaxed);
+  if (last == 0 || period <= 0)
+    return false;
+
+  long long t = now.time_since_epoch().count();
+  if (t - last > MAX_SILENT_PERIODS * period)
+    return false;
+
+  // the last expected arrival, less the margin, up to limit
+  long long base = last - ticks(margin);
+  long long end = limit.time_since_epoch().count();
+  if (end - base >= period)
+    end = base + (end - base) / period * period;
+  // with too little time left the search runs until limit instead
+  if (end - t < ticks(min_budget))
+    end = limit.time_since_epoch().count();
+
+  *deadline = steady_clock::time_point(steady_clock::duration(end));
+  return true;
+}
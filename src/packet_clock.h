@@ -0,0 +1,35 @@
+#ifndef PACKET_CLOCK_H
+#define PACKET_CLOCK_H
+
+#include <atomic>
+#include <chrono>
+
+// Estimate of when the next UpdateMessage arrives, so decide() can be sized
+// to finish right before it. The communication thread marks every arrival,
+// the period is a moving average of the intervals (gaps from lost packets
+// are left out) and the phase is the last arrival. Intervals left out several
+// times in a row start the period over, it was wrong or the packets slowed.
+
+struct PacketClock {
+  // steady_clock ticks, 0 while unknown
+  std::atomic<long long> last{0};
+  std::atomic<long long> period{0};
+  // intervals left out in a row and the shortest of them, only touched by
+  // packet_clock_mark
+  int rejected = 0;
+  long long rejected_min = 0;
+};
+
+void packet_clock_mark(PacketClock &clock,
+                       std::chrono::steady_clock::time_point arrival);
+
+// time the search should be done by, margin seconds before the last packet
+// expected up to limit, limit if that leaves less than min_budget seconds
+// from now; false if the packets can't be predicted
+bool packet_clock_deadline(const PacketClock &clock,
+                           std::chrono::steady_clock::time_point now,
+                           std::chrono::steady_clock::time_point limit,
+                           float margin, float min_budget,
+                           std::chrono::steady_clock::time_point *deadline);
+
+#endif
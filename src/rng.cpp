@@ -0,0 +1,107 @@
+#include <cmath>
+#include <random>
+
+#include "rng.h"
+
+static constexpr uint32_t PHILOX_M0 = 0xD2511F53;
+static constexpr uint32_t PHILOX_M1 = 0xCD9E8D57;
+static constexpr uint32_t PHILOX_W0 = 0x9E3779B9;
+static constexpr uint32_t PHILOX_W1 = 0xBB67AE85;
+static constexpr int PHILOX_ROUNDS = 10;
+
+static void philox(const uint32_t counter[4], const uint32_t key[2],
+                   uint32_t out[4]) {
+  uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+  uint32_t k0 = key[0], k1 = key[1];
+
+  for (int r = 0; r < PHILOX_ROUNDS; r++) {
+    uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+    uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+    c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+    c1 = (uint32_t)p1;
+    c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+    c3 = (uint32_t)p0;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+uint32_t rng_fresh_seed() {
+  std::random_device rd;
+  uint32_t seed;
+  // positive int so it can be typed back as DECISION_SEED, 0 means unset
+  do {
+    seed = rd() & 0x7fffffff;
+  } while (seed == 0);
+  return seed;
+}
+
+void rng_seed(Rng &rng, uint64_t seed, uint64_t stream) {
+  rng.key[0] = (uint32_t)seed;
+  rng.key[1] = (uint32_t)(seed >> 32);
+  rng.counter[0] = 0;
+  rng.counter[1] = 0;
+  rng.counter[2] = (uint32_t)stream;
+  rng.counter[3] = (uint32_t)(stream >> 32);
+  rng.index = 4;
+  rng.seeded = true;
+  rng.has_normal = false;
+}
+
+Rng &thread_rng() {
+  static thread_local Rng rng;
+  if (!rng.seeded)
+    rng_seed(rng, rng_fresh_seed());
+  return rng;
+}
+
+uint32_t rng_next(Rng &rng) {
+  if (rng.index >= 4) {
+    philox(rng.counter, rng.key, rng.buffer);
+    if (++rng.counter[0] == 0)
+      ++rng.counter[1];
+    rng.index = 0;
+  }
+  return rng.buffer[rng.index++];
+}
+
+int rng_int(Rng &rng, int n) {
+  return (int)(((uint64_t)rng_next(rng) * (uint32_t)n) >> 32);
+}
+
+// 24 random bits, uniform in [0, 1)
+static float unit_float(uint32_t x) { return (x >> 8) * (1.0f / (1 << 24)); }
+
+float rng_uniform(Rng &rng, float a, float b) {
+  return a + (b - a) * unit_float(rng_next(rng));
+}
+
+float rng_normal(Rng &rng) {
+  if (rng.has_normal) {
+    rng.has_normal = false;
+    return rng.normal;
+  }
+
+  // Box-Muller, u1 in (0, 1] to keep the log finite
+  float u1 = 1.0f - unit_float(rng_next(rng));
+  float u2 = unit_float(rng_next(rng));
+  float r = std::sqrt(-2.0f * std::log(u1));
+  float theta = 2.0f * (float)M_PI * u2;
+
+  rng.normal = r * std::sin(theta);
+  rng.has_normal = true;
+  return r * std::cos(theta);
+}
+
+void rng_uniform_vectors(Rng &rng, Vector *out, int n, float rx, float ry) {
+  for (int i = 0; i < n; i++) {
+    float x = unit_float(rng_next(rng)) - 0.5f;
+    float y = unit_float(rng_next(rng)) - 0.5f;
+    out[i] = {x * rx, y * ry};
+  }
+}
@@ -0,0 +1,45 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+#include "vector.h"
+
+// Counter based random number generator (Philox4x32-10). A generator is
+// fully determined by (seed, stream, counter), so setting the stream is
+// enough to get an independent sequence: decide() uses one stream per
+// candidate, which makes a run reproducible from its seed no matter which
+// thread evaluated which candidate.
+struct Rng {
+  uint32_t key[2] = {};
+  uint32_t counter[4] = {};
+  uint32_t buffer[4] = {};
+  int index = 4;
+  bool seeded = false;
+  bool has_normal = false;
+  float normal = 0.0;
+};
+
+// random seed taken from the system, in [1, INT_MAX]
+uint32_t rng_fresh_seed();
+
+void rng_seed(Rng &rng, uint64_t seed, uint64_t stream = 0);
+
+// generator of the calling thread, seeded with a fresh seed on first use
+Rng &thread_rng();
+
+uint32_t rng_next(Rng &rng);
+
+// uniform in [0, n)
+int rng_int(Rng &rng, int n);
+
+// uniform in [a, b)
+float rng_uniform(Rng &rng, float a, float b);
+
+// standard normal
+float rng_normal(Rng &rng);
+
+// fill out with n uniform vectors in [-rx/2, rx/2) x [-ry/2, ry/2)
+void rng_uniform_vectors(Rng &rng, Vector *out, int n, float rx, float ry);
+
+#endif
@@ -1,8 +1,10 @@
 #ifndef SEGMENT_H
 #define SEGMENT_H
 
-struct Segment {
-  float u, d;
+template <typename T> struct BasicSegment {
+  T u, d;
 };
 
+typedef BasicSegment<float> Segment;
+
 #endif
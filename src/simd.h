@@ -0,0 +1,193 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Minimal float lanes used by the batched evaluation, one candidate per lane.
+// AVX gives 8 lanes, SSE2 (always there on x86-64) 4 and anything else falls
+// back to a single scalar lane. Only plain IEEE operations are exposed so a
+// lane computes exactly what the scalar code computes for the same inputs.
+
+#if defined(__AVX__)
+#include <immintrin.h>
+constexpr int SIMD_WIDTH = 8;
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+constexpr int SIMD_WIDTH = 4;
+#else
+#include <cmath>
+constexpr int SIMD_WIDTH = 1;
+#endif
+
+#if defined(__AVX__)
+
+struct Floats {
+  __m256 v;
+};
+struct Mask {
+  __m256 v;
+};
+
+inline Floats floats_set(float x) { return {_mm256_set1_ps(x)}; }
+inline Floats floats_load(const float *p) { return {_mm256_loadu_ps(p)}; }
+inline void floats_store(float *p, Floats a) { _mm256_storeu_ps(p, a.v); }
+
+inline Floats operator+(Floats a, Floats b) {
+  return {_mm256_add_ps(a.v, b.v)};
+}
+inline Floats operator-(Floats a, Floats b) {
+  return {_mm256_sub_ps(a.v, b.v)};
+}
+inline Floats operator*(Floats a, Floats b) {
+  return {_mm256_mul_ps(a.v, b.v)};
+}
+inline Floats operator/(Floats a, Floats b) {
+  return {_mm256_div_ps(a.v, b.v)};
+}
+inline Floats operator-(Floats a) {
+  return {_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))};
+}
+inline Floats floats_sqrt(Floats a) { return {_mm256_sqrt_ps(a.v)}; }
+
+inline Mask operator<(Floats a, Floats b) {
+  return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)};
+}
+inline Mask operator>=(Floats a, Floats b) {
+  return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)};
+}
+inline Mask operator==(Floats a, Floats b) {
+  return {_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)};
+}
+inline Mask operator!=(Floats a, Floats b) {
+  return {_mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ)};
+}
+
+// lanes of a where m is set, of b elsewhere
+inline Floats select(Mask m, Floats a, Floats b) {
+  return {_mm256_blendv_ps(b.v, a.v, m.v)};
+}
+
+inline Mask operator&(Mask a, Mask b) { return {_mm256_and_ps(a.v, b.v)}; }
+inline Mask operator|(Mask a, Mask b) { return {_mm256_or_ps(a.v, b.v)}; }
+// bit i set if lane i is set
+inline int mask_bits(Mask m) { return _mm256_movemask_ps(m.v); }
+
+// t1, t2 = (-b -+ sqrt(delta)) / a with the sqrt and the division done in
+// double precision, like the scalar code does through sqrt(double)
+inline void floats_roots(Floats b, Floats delta, Floats a, Floats *t1,
+                         Floats *t2) {
+  __m256d r1[2], r2[2];
+  for (int h = 0; h < 2; h++) {
+    __m128 bh = h ? _mm256_extractf128_ps(b.v, 1) : _mm256_castps256_ps128(b.v);
+    __m128 dh = h ? _mm256_extractf128_ps(delta.v, 1)
+                  : _mm256_castps256_ps128(delta.v);
+    __m128 ah = h ? _mm256_extractf128_ps(a.v, 1) : _mm256_castps256_ps128(a.v);
+    __m256d nb = _mm256_cvtps_pd(_mm_xor_ps(bh, _mm_set1_ps(-0.0f)));
+    __m256d sq = _mm256_sqrt_pd(_mm256_cvtps_pd(dh));
+    __m256d ad = _mm256_cvtps_pd(ah);
+    r1[h] = _mm256_div_pd(_mm256_sub_pd(nb, sq), ad);
+    r2[h] = _mm256_div_pd(_mm256_add_pd(nb, sq), ad);
+  }
+  t1->v = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(r1[0])),
+                               _mm256_cvtpd_ps(r1[1]), 1);
+  t2->v = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(r2[0])),
+                               _mm256_cvtpd_ps(r2[1]), 1);
+}
+
+#elif defined(__SSE2__)
+
+struct Floats {
+  __m128 v;
+};
+struct Mask {
+  __m128 v;
+};
+
+inline Floats floats_set(float x) { return {_mm_set1_ps(x)}; }
+inline Floats floats_load(const float *p) { return {_mm_loadu_ps(p)}; }
+inline void floats_store(float *p, Floats a) { _mm_storeu_ps(p, a.v); }
+
+inline Floats operator+(Floats a, Floats b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Floats operator-(Floats a, Floats b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Floats operator*(Floats a, Floats b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Floats operator/(Floats a, Floats b) { return {_mm_div_ps(a.v, b.v)}; }
+inline Floats operator-(Floats a) {
+  return {_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))};
+}
+inline Floats floats_sqrt(Floats a) { return {_mm_sqrt_ps(a.v)}; }
+
+inline Mask operator<(Floats a, Floats b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+inline Mask operator>=(Floats a, Floats b) { return {_mm_cmpge_ps(a.v, b.v)}; }
+inline Mask operator==(Floats a, Floats b) { return {_mm_cmpeq_ps(a.v, b.v)}; }
+inline Mask operator!=(Floats a, Floats b) {
+  return {_mm_cmpneq_ps(a.v, b.v)};
+}
+
+// lanes of a where m is set, of b elsewhere
+inline Floats select(Mask m, Floats a, Floats b) {
+  return {_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))};
+}
+
+inline Mask operator&(Mask a, Mask b) { return {_mm_and_ps(a.v, b.v)}; }
+inline Mask operator|(Mask a, Mask b) { return {_mm_or_ps(a.v, b.v)}; }
+// bit i set if lane i is set
+inline int mask_bits(Mask m) { return _mm_movemask_ps(m.v); }
+
+// t1, t2 = (-b -+ sqrt(delta)) / a with the sqrt and the division done in
+// double precision, like the scalar code does through sqrt(double)
+inline void floats_roots(Floats b, Floats delta, Floats a, Floats *t1,
+                         Floats *t2) {
+  __m128 nb = _mm_xor_ps(b.v, _mm_set1_ps(-0.0f));
+  __m128d r1[2], r2[2];
+  for (int h = 0; h < 2; h++) {
+    __m128 bh = h ? _mm_movehl_ps(nb, nb) : nb;
+    __m128 dh = h ? _mm_movehl_ps(delta.v, delta.v) : delta.v;
+    __m128 ah = h ? _mm_movehl_ps(a.v, a.v) : a.v;
+    __m128d nbd = _mm_cvtps_pd(bh);
+    __m128d sq = _mm_sqrt_pd(_mm_cvtps_pd(dh));
+    __m128d ad = _mm_cvtps_pd(ah);
+    r1[h] = _mm_div_pd(_mm_sub_pd(nbd, sq), ad);
+    r2[h] = _mm_div_pd(_mm_add_pd(nbd, sq), ad);
+  }
+  t1->v = _mm_movelh_ps(_mm_cvtpd_ps(r1[0]), _mm_cvtpd_ps(r1[1]));
+  t2->v = _mm_movelh_ps(_mm_cvtpd_ps(r2[0]), _mm_cvtpd_ps(r2[1]));
+}
+
+#else
+
+struct Floats {
+  float v;
+};
+struct Mask {
+  bool v;
+};
+
+inline Floats floats_set(float x) { return {x}; }
+inline Floats floats_load(const float *p) { return {*p}; }
+inline void floats_store(float *p, Floats a) { *p = a.v; }
+
+inline Floats operator+(Floats a, Floats b) { return {a.v + b.v}; }
+inline Floats operator-(Floats a, Floats b) { return {a.v - b.v}; }
+inline Floats operator*(Floats a, Floats b) { return {a.v * b.v}; }
+inline Floats operator/(Floats a, Floats b) { return {a.v / b.v}; }
+inline Floats operator-(Floats a) { return {-a.v}; }
+inline Floats floats_sqrt(Floats a) { return {std::sqrt(a.v)}; }
+
+inline Mask operator<(Floats a, Floats b) { return {a.v < b.v}; }
+inline Mask operator>=(Floats a, Floats b) { return {a.v >= b.v}; }
+inline Mask operator==(Floats a, Floats b) { return {a.v == b.v}; }
+inline Mask operator!=(Floats a, Floats b) { return {a.v != b.v}; }
+
+inline Floats select(Mask m, Floats a, Floats b) { return {m.v ? a.v : b.v}; }
+
+inline Mask operator&(Mask a, Mask b) { return {a.v && b.v}; }
+inline Mask operator|(Mask a, Mask b) { return {a.v || b.v}; }
+inline int mask_bits(Mask m) { return m.v; }
+
+inline void floats_roots(Floats b, Floats delta, Floats a, Floats *t1,
+                         Floats *t2) {
+  t1->v = (-b.v - std::sqrt((double)delta.v)) / a.v;
+  t2->v = (-b.v + std::sqrt((double)delta.v)) / a.v;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef SORT_NETWORK_H
+#define SORT_NETWORK_H
+
+// Batcher's odd-even merge sort unrolled at compile time for N elements, the
+// loops of the merge exchange become template recursion so only the
+// compare-exchanges are left. less must be a strict weak order; elements it
+// finds equivalent may end up in any order.
+
+template <typename T, typename Less>
+inline void compare_exchange(T &a, T &b, Less less) {
+  bool swap = less(b, a);
+  T first = swap ? b : a;
+  T second = swap ? a : b;
+  a = first;
+  b = second;
+}
+
+template <int N, int P, int K, int J, int I,
+          bool done = (I > K - 1 || I > N - J - K - 1)>
+struct SortNetworkI {
+  template <typename T, typename Less> static void apply(T *x, Less less) {
+    if ((I + J) / (2 * P) == (I + J + K) / (2 * P))
+      compare_exchange(x[I + J], x[I + J + K], less);
+    SortNetworkI<N, P, K, J, I + 1>::apply(x, less);
+  }
+};
+
+template <int N, int P, int K, int J, int I>
+struct SortNetworkI<N, P, K, J, I, true> {
+  template <typename T, typename Less> static void apply(T *, Less) {}
+};
+
+template <int N, int P, int K, int J, bool done = (J > N - 1 - K)>
+struct SortNetworkJ {
+  template <typename T, typename Less> static void apply(T *x, Less less) {
+    SortNetworkI<N, P, K, J, 0>::apply(x, less);
+    SortNetworkJ<N, P, K, J + 2 * K>::apply(x, less);
+  }
+};
+
+template <int N, int P, int K, int J> struct SortNetworkJ<N, P, K, J, true> {
+  template <typename T, typename Less> static void apply(T *, Less) {}
+};
+
+template <int N, int P, int K, bool done = (K < 1)> struct SortNetworkK {
+  template <typename T, typename Less> static void apply(T *x, Less less) {
+    SortNetworkJ<N, P, K, K % P>::apply(x, less);
+    SortNetworkK<N, P, K / 2>::apply(x, less);
+  }
+};
+
+template <int N, int P, int K> struct SortNetworkK<N, P, K, true> {
+  template <typename T, typename Less> static void apply(T *, Less) {}
+};
+
+template <int N, int P = 1, bool done = (P >= N)> struct SortNetwork {
+  template <typename T, typename Less> static void apply(T *x, Less less) {
+    SortNetworkK<N, P, P>::apply(x, less);
+    SortNetwork<N, 2 * P>::apply(x, less);
+  }
+};
+
+template <int N, int P> struct SortNetwork<N, P, true> {
+  template <typename T, typename Less> static void apply(T *, Less) {}
+};
+
+// sorts count elements, up to N, with the network for exactly count
+template <int N> struct SortUpTo {
+  template <typename T, typename Less>
+  static void apply(T *x, int count, Less less) {
+    if (count == N)
+      SortNetwork<N>::apply(x, less);
+    else
+      SortUpTo<N - 1>::apply(x, count, less);
+  }
+};
+
+template <> struct SortUpTo<1> {
+  template <typename T, typename Less> static void apply(T *, int, Less) {}
+};
+
+#endif
@@ -11,24 +11,59 @@
 #include "decision.h"
 #include "decision_table.h"
 #include "id_table.h"
+#include "rng.h"
+#include "simd.h"
+#include "sort_network.h"
+
+BasicState<Dual> dual_state(const State &state) {
+  BasicState<Dual> dual;
+  dual.ball = state.ball;
+  dual.ball_v = state.ball_v;
+  FOR_EVERY_ROBOT(i) {
+    dual.robots[i] = state.robots[i];
+    dual.robots_v[i] = state.robots_v[i];
+  }
+  return dual;
+}
+
+State value_of(const BasicState<Dual> &dual) {
+  State state;
+  state.ball = value_of(dual.ball);
+  state.ball_v = value_of(dual.ball_v);
+  FOR_EVERY_ROBOT(i) {
+    state.robots[i] = value_of(dual.robots[i]);
+    state.robots_v[i] = value_of(dual.robots_v[i]);
+  }
+  return state;
+}
 
 State uniform_rand_state() {
   State s;
 
-  FOR_EVERY_ROBOT(i)
-  s.robots[i] = uniform_rand_vector(FIELD_WIDTH, FIELD_HEIGHT);
+  rng_uniform_vectors(thread_rng(), s.robots._, 2 * N_ROBOTS, FIELD_WIDTH,
+                      FIELD_HEIGHT);
 
   s.ball = uniform_rand_vector(FIELD_WIDTH, FIELD_HEIGHT);
   return s;
 }
 
-bool can_kick_directly(State state, Player player) {
+bool can_kick_directly(const State &state, Player player) {
   int rwb = robot_with_ball(state);
   if (player != PLAYER_OF(rwb))
     return false;
 
+  int gaps_count;
+  Segment gaps[N_ROBOTS * 2];
+  discover_gaps_from_pos(state, state.ball, ENEMY_FOR(player), gaps,
+                         &gaps_count, rwb);
+  return can_kick_from_gaps(state, player, gaps, gaps_count);
+}
+
+bool can_kick_from_gaps(const State &state, Player player, const Segment *gaps,
+                        int gaps_count) {
   Player enemy = ENEMY_FOR(player);
-  float linear_gap = total_gap_len_from_pos(state, state.ball, enemy, rwb);
+  float linear_gap = 0.0;
+  FOR_N(i, gaps_count) { linear_gap += gaps[i].u - gaps[i].d; }
   float dist_to_goal = dist(state.ball, GOAL_POS(enemy));
   float angular_gap = DEGREES(2 * atan2f(linear_gap / 2, dist_to_goal));
 
@@ -50,8 +85,9 @@ Board::getRobotWithVirtualBall(const Ball &virt_ball,
 // float time_to_pos(Vector rpos, Vector rpos_v, Vector pos, Vector
 // pos_v, float
 // max_speed);
-float time_to_pos(Vector rpos, Vector, Vector pos, Vector pos_v,
-                  float max_speed) {
+template <typename T>
+T time_to_pos(BasicVector<T> rpos, BasicVector<T>, BasicVector<T> pos,
+              BasicVector<T> pos_v, float max_speed) {
   // TODO: take into account rpos_v
 
   /*
@@ -68,17 +104,17 @@ float time_to_pos(Vector rpos, Vector, Vector pos, Vector pos_v,
    */
 
   // vb.(pb - pr)
-  float a = SQ(max_speed) - norm2(pos_v);
-  float c = -norm2(rpos - pos);
-  float b_div_2 = pos_v * (rpos - pos);
-  float delta_div_4 = b_div_2 * b_div_2 - a * c;
+  T a = SQ(max_speed) - norm2(pos_v);
+  T c = -norm2(rpos - pos);
+  T b_div_2 = pos_v * (rpos - pos);
+  T delta_div_4 = b_div_2 * b_div_2 - a * c;
 
   if (a != 0) {
     // It's impossible to reach the ball
     if (delta_div_4 < 0) {
       return std::numeric_limits<float>::max();
     } else if (delta_div_4 == 0) {
-      float t = -b_div_2 / a;
+      T t = -b_div_2 / a;
 
       if (t >= 0)
         return t;
@@ -86,11 +122,11 @@ float time_to_pos(Vector rpos, Vector, Vector pos, Vector pos_v,
         return std::numeric_limits<float>::max();
     } else {
       // delta_div_4 > 0
-      float t1 = (-b_div_2 - sqrt(delta_div_4)) / a,
-            t2 = (-b_div_2 + sqrt(delta_div_4)) / a;
+      T t1 = (-b_div_2 - sqrt(delta_div_4)) / a,
+        t2 = (-b_div_2 + sqrt(delta_div_4)) / a;
 
-      float t_min = std::min(t1, t2);
-      float t_max = std::max(t1, t2);
+      T t_min = std::min(t1, t2);
+      T t_max = std::max(t1, t2);
 
       if (t_max < 0)
         return std::numeric_limits<float>::max();
@@ -107,18 +143,51 @@ float time_to_pos(Vector rpos, Vector, Vector pos, Vector pos_v,
   }
 }
 
-float time_to_obj(const State state, int r, Vector obj, Vector obj_v) {
+template float time_to_pos(Vector, Vector, Vector, Vector, float);
+template Dual time_to_pos(BasicVector<Dual>, BasicVector<Dual>,
+                          BasicVector<Dual>, BasicVector<Dual>, float);
+
+Floats time_to_pos_lanes(Floats rx, Floats ry, Floats px, Floats py,
+                         Floats pvx, Floats pvy, Floats a) {
+  const Floats zero = floats_set(0);
+  const Floats max_time = floats_set(std::numeric_limits<float>::max());
+
+  Floats dx = rx - px;
+  Floats dy = ry - py;
+  Floats c = -(dx * dx + dy * dy);
+  Floats b_div_2 = pvx * dx + pvy * dy;
+  Floats delta_div_4 = b_div_2 * b_div_2 - a * c;
+
+  Floats t_one = -b_div_2 / a;
+  t_one = select(t_one >= zero, t_one, max_time);
+
+  Floats t1, t2;
+  floats_roots(b_div_2, delta_div_4, a, &t1, &t2);
+  Floats t_min = select(t2 < t1, t2, t1);
+  Floats t_max = select(t1 < t2, t2, t1);
+  Floats t_two =
+      select(t_max < zero, max_time, select(t_min < zero, t_max, t_min));
+
+  Floats t = select(delta_div_4 < zero, max_time,
+                    select(delta_div_4 == zero, t_one, t_two));
+  return select(a != zero, t, zero);
+}
+
+template <typename T>
+T time_to_obj(const BasicState<T> &state, int r, BasicVector<T> obj,
+              BasicVector<T> obj_v) {
   return time_to_pos(state.robots[r], state.robots_v[r], obj, obj_v);
 }
 
-int robot_with_ball(const State state, float *time_min, float *time_max,
+template <typename T>
+int robot_with_ball(const BasicState<T> &state, T *time_min, T *time_max,
                     int *robot_min, int *robot_max) {
   int robot = 0;
   int best_robot_max = 0;
   int best_robot_min = 0;
-  float best_time = std::numeric_limits<float>::infinity();
-  float best_time_min = std::numeric_limits<float>::infinity();
-  float best_time_max = std::numeric_limits<float>::infinity();
+  T best_time = std::numeric_limits<float>::infinity();
+  T best_time_min = std::numeric_limits<float>::infinity();
+  T best_time_max = std::numeric_limits<float>::infinity();
 
 #define KEEP_BEST(BEST, ROBOT)                                                 \
   do {                                                                         \
@@ -129,7 +198,7 @@ int robot_with_ball(const State state, float *time_min, float *time_max,
   } while (0)
 
   FOR_EVERY_ROBOT(i) {
-    float t = time_to_obj(state, i, state.ball, state.ball_v);
+    T t = time_to_obj(state, i, state.ball, state.ball_v);
 
     KEEP_BEST(best_time, robot);
     if (PLAYER_OF(i) == MIN)
@@ -155,7 +224,11 @@ int robot_with_ball(const State state, float *time_min, float *time_max,
   return robot;
 }
 
-int can_receive_pass(const State state, int vrobot, Player player, Vector vpos,
+template int robot_with_ball(const State &, float *, float *, int *, int *);
+template int robot_with_ball(const BasicState<Dual> &, Dual *, Dual *, int *,
+                             int *);
+
+int can_receive_pass(const State &state, int vrobot, Player player, Vector vpos,
                      Vector vball, Vector vball_v) {
   int robot = vrobot;
   // XXX: speed 0 for us maybe?
@@ -217,11 +290,11 @@ bool shadow_for_robot_from_pos(Vector rpos, Vector pos, float gx, Segment *shado
 }
 
 #else
-struct Sol {
-  float x1, x2;
+template <typename T> struct Sol {
+  T x1, x2;
 };
 
-bool solve_lineq(float a, float b, Sol &x, float c) {
+template <typename T> bool solve_lineq(T a, T b, Sol<T> &x, T c) {
   if (a == 0 && b == 0) {
     if (c == 0) {
       x.x1 = x.x2 = 0;
@@ -240,8 +313,9 @@ bool solve_lineq(float a, float b, Sol &x, float c) {
   }
 }
 
-bool linear_dependency(float a1, float a2, float &x, float b1, float b2) {
-  float norm_a = sqrt(a1 * a1 + a2 * a2), norm_b = sqrt(b1 * b1 + b2 * b2),
+template <typename T>
+bool linear_dependency(T a1, T a2, T &x, T b1, T b2) {
+  T norm_a = sqrt(a1 * a1 + a2 * a2), norm_b = sqrt(b1 * b1 + b2 * b2),
         norm_ab = sqrt((a1 + b1) * (a1 + b1) + (a2 + b2) * (a2 + b2));
 
   if (norm_ab == norm_a + norm_b) {
@@ -262,11 +336,11 @@ bool linear_dependency(float a1, float a2, float &x, float b1, float b2) {
   }
 }
 
-bool solve_Ax_b(float a11, float a12, float a21, float a22, Sol &x, float b1,
-                float b2) {
+template <typename T>
+bool solve_Ax_b(T a11, T a12, T a21, T a22, Sol<T> &x, T b1, T b2) {
   // x1 = (b1 . a22 - a12 . b2) / det
   // x2 = (b2 . a11 - a21 . b1) / det
-  float det = a11 * a22 - a12 * a21;
+  T det = a11 * a22 - a12 * a21;
   if (det == 0) {
     // parallel lines case
     if (a11 * a22 != 0) {
@@ -310,8 +384,9 @@ bool solve_Ax_b(float a11, float a12, float a21, float a22, Sol &x, float b1,
   return true;
 }
 
-bool shadow_for_robot_from_pos(Vector rpos, Vector pos, float gx,
-                               Segment *shadow) {
+template <typename T>
+bool shadow_for_robot_from_pos(BasicVector<T> rpos, BasicVector<T> pos,
+                               float gx, BasicSegment<T> *shadow) {
   auto d = rpos - pos;
   auto k = norm2(d) - SQ(ROBOT_RADIUS);
 
@@ -330,16 +405,16 @@ bool shadow_for_robot_from_pos(Vector rpos, Vector pos, float gx,
   // tan_alpha);
   // float tan_2 = (tan_theta - tan_alpha) / (1 + tan_theta *
   // tan_alpha);
-  float y_shadow_1; // = tan_1 * std::fabs(ball.pos()[0] - gx) +
+  T y_shadow_1; // = tan_1 * std::fabs(ball.pos()[0] - gx) +
                     // ball.pos()[1];
-  float y_shadow_2; // = tan_2 * std::fabs(ball.pos()[0] - gx) +
+  T y_shadow_2; // = tan_2 * std::fabs(ball.pos()[0] - gx) +
                     // ball.pos()[1];
   // New
   // n: vector normal to the line that join
   //    ball and the robot
   // n = [ 0 1 ]
   //     [-1 0 ].(b.pos() - r.pos())/|| b.pos() - r.pos() ||
-  Vector n = {rpos.y - pos.y, pos.x - rpos.x};
+  BasicVector<T> n = {rpos.y - pos.y, pos.x - rpos.x};
   // normalization, to use radius later
   n = n * (1.0 / norm(d));
 
@@ -361,9 +436,9 @@ bool shadow_for_robot_from_pos(Vector rpos, Vector pos, float gx,
   // solving sistem: [ nu_x  nd_x ] [ auxu ]
   //                 [ nu_y  nd_y ] [ auxd ] = Rd - Ru
   // to eliminate robots with no shadow
-  Sol aux = {0.0, 0.0};
+  Sol<T> aux = {0, 0};
 
-  if (solve_Ax_b(nu.x, nd.x, nu.y, nd.y, aux, (rd - ru).x, (rd - ru).y)) {
+  if (solve_Ax_b<T>(nu.x, nd.x, nu.y, nd.y, aux, (rd - ru).x, (rd - ru).y)) {
     // system has solution
     // p = intersection of lu = { aux . nu + ru} and
     //                     ld = { aux . nd + rd}
@@ -385,7 +460,7 @@ bool shadow_for_robot_from_pos(Vector rpos, Vector pos, float gx,
   //
   //     [ nu/d_x   0 ] [ ku/d'] = [ gx - ru/d_x ]
   // --> [ nu/d_y  -1 ] [ yu/d ] = [    - ru/d_y ]
-  if (solve_Ax_b(nu.x, 0, nu.y, -1, aux, gx - ru.x, -ru.y)) {
+  if (solve_Ax_b<T>(nu.x, 0, nu.y, -1, aux, gx - ru.x, -ru.y)) {
     // system has solution: aux --> ku', yu
     y_shadow_1 = aux.x2;
   } else {
@@ -395,7 +470,7 @@ bool shadow_for_robot_from_pos(Vector rpos, Vector pos, float gx,
       y_shadow_1 = -std::numeric_limits<float>::infinity();
   }
 
-  if (solve_Ax_b(nd.x, 0, nd.y, -1, aux, gx - rd.x, -rd.y)) {
+  if (solve_Ax_b<T>(nd.x, 0, nd.y, -1, aux, gx - rd.x, -rd.y)) {
     // system has solution: aux --> kd', yd
     y_shadow_2 = aux.x2;
   } else {
@@ -416,8 +491,8 @@ bool shadow_for_robot_from_pos(Vector rpos, Vector pos, float gx,
   //}
   // --------------------------------------------------------------------------
 
-  float u_shadow = std::max(y_shadow_1, y_shadow_2);
-  float d_shadow = std::min(y_shadow_1, y_shadow_2);
+  T u_shadow = std::max(y_shadow_1, y_shadow_2);
+  T d_shadow = std::min(y_shadow_1, y_shadow_2);
 
   if (u_shadow <= -GOAL_WIDTH / 2 || d_shadow >= GOAL_WIDTH / 2)
     return false;
@@ -426,15 +501,185 @@ bool shadow_for_robot_from_pos(Vector rpos, Vector pos, float gx,
   shadow->d = d_shadow;
   return true;
 }
+
+template bool shadow_for_robot_from_pos(Vector, Vector, float, Segment *);
+template bool shadow_for_robot_from_pos(BasicVector<Dual>, BasicVector<Dual>,
+                                        float, BasicSegment<Dual> *);
 #endif
 
-bool cmp_segments(Segment a, Segment b) {
+// edge on x = gx of the line from pos + offset * n to rpos + radius * n, n the
+// normal of shadow_for_robot_from_pos, and its derivatives to rpos and pos
+static float shadow_edge_gradient(Vector rpos, Vector pos, float gx,
+                                  float radius, float offset, Vector *d_rpos,
+                                  Vector *d_pos) {
+  auto d = rpos - pos;
+  float l = norm(d);
+  Vector n = Vector(d.y, -d.x) / l;
+  auto ru = rpos + n * radius;
+  auto nu = d + n * (radius - offset);
+  if (nu.x == 0) {
+    *d_rpos = *d_pos = {};
+    return nu.y > 0 ? std::numeric_limits<float>::infinity()
+                    : -std::numeric_limits<float>::infinity();
+  }
+
+  // derivatives of n to d, n = (d.y, -d.x) / |d|
+  float m00 = 1 - d.x * d.x / (l * l), m01 = -d.x * d.y / (l * l),
+        m11 = 1 - d.y * d.y / (l * l);
+  Vector dnx = Vector(m01, m11) / l, dny = Vector(-m00, -m01) / l;
+
+  float slope = nu.y / nu.x;
+  float k = gx - ru.x;
+  Vector dnux = Vector(1, 0) + dnx * (radius - offset);
+  Vector dnuy = Vector(0, 1) + dny * (radius - offset);
+  Vector dslope = (dnuy - dnux * slope) / nu.x;
+  Vector dy_d = dny * radius - dnx * (radius * slope) + dslope * k;
+
+  // rpos is also in ru, pos only through d
+  *d_rpos = Vector(-slope, 1) + dy_d;
+  *d_pos = Vector() - dy_d;
+  return ru.y + k * slope;
+}
+
+void shadow_gradient(Vector rpos, Vector pos, float gx, ShadowGradient *grad) {
+  Vector d1_rpos, d1_pos, d2_rpos, d2_pos;
+  float y1 = shadow_edge_gradient(rpos, pos, gx, ROBOT_RADIUS,
+                                  KICK_POS_VARIATION, &d1_rpos, &d1_pos);
+  float y2 = shadow_edge_gradient(rpos, pos, gx, -ROBOT_RADIUS,
+                                  -KICK_POS_VARIATION, &d2_rpos, &d2_pos);
+  bool first_up = y1 >= y2;
+  grad->du_rpos = first_up ? d1_rpos : d2_rpos;
+  grad->du_pos = first_up ? d1_pos : d2_pos;
+  grad->dd_rpos = first_up ? d2_rpos : d1_rpos;
+  grad->dd_pos = first_up ? d2_pos : d1_pos;
+}
+
+Vector time_to_pos_gradient(Vector rpos, Vector pos, Vector pos_v,
+                            float max_speed) {
+  float t = time_to_pos(rpos, {}, pos, pos_v, max_speed);
+  float a = SQ(max_speed) - norm2(pos_v);
+  float b_div_2 = pos_v * (rpos - pos);
+  if (a == 0 || t == std::numeric_limits<float>::max())
+    return {};
+
+  // implicit derivative of a.t^2 + 2.b_div_2.t + c = 0
+  float den = a * t + b_div_2;
+  if (den == 0)
+    return {};
+  return ((rpos - pos) - pos_v * t) / den;
+}
+
+// same steps as shadow_for_robot_from_pos, one robot per lane; lanes that hit
+// one of the degenerate systems solve_Ax_b special-cases are redone by it
+int shadows_from_pos(const State &state, Vector pos, float gx, Segment *shadows,
+                     int *robots, int ignore_robot) {
+  constexpr int LANES =
+      (2 * N_ROBOTS + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+
+  // structure of arrays, padding robots sit on pos so they cast no shadow
+  float xs[LANES], ys[LANES], us[LANES], ds[LANES];
+  FOR_N(i, LANES) {
+    Vector r = i < 2 * N_ROBOTS ? state.robots[i] : pos;
+    xs[i] = r.x;
+    ys[i] = r.y;
+  }
+
+  Floats zero = floats_set(0), one = floats_set(1), minus_one = floats_set(-1);
+  Floats g = floats_set(gx), px = floats_set(pos.x), py = floats_set(pos.y);
+  Floats up = floats_set(ROBOT_RADIUS), down = floats_set(-ROBOT_RADIUS);
+  Floats kick_up = floats_set(KICK_POS_VARIATION);
+  Floats kick_down = floats_set(-KICK_POS_VARIATION);
+
+  int count = 0;
+  for (int l = 0; l < LANES; l += SIMD_WIDTH) {
+    Floats rx = floats_load(xs + l), ry = floats_load(ys + l);
+    Floats dx = rx - px, dy = ry - py;
+    Floats d2 = dx * dx + dy * dy;
+    Floats k = d2 - floats_set(SQ(ROBOT_RADIUS));
+    int early = mask_bits((zero >= k) | (zero >= dx * g));
+
+    Floats inv = one / floats_sqrt(d2);
+    Floats nx = dy * inv, ny = (px - rx) * inv;
+    Floats rux = nx * up + rx, ruy = ny * up + ry;
+    Floats rdx = nx * down + rx, rdy = ny * down + ry;
+    Floats nux = rux - (nx * kick_up + px), nuy = ruy - (ny * kick_up + py);
+    Floats ndx = rdx - (nx * kick_down + px), ndy = rdy - (ny * kick_down + py);
+
+    // intersection of the tangent lines
+    Floats det = nux * ndy - ndx * nuy;
+    Floats x1 = ((rdx - rux) * ndy - ndx * (rdy - ruy)) / det;
+    Floats ix = nux * x1 + rux;
+    Mask behind = (zero < x1) & (gx < 0 ? g < ix : ix < g);
+
+    // tangent lines on the goal line
+    Floats det_u = nux * minus_one - zero * nuy;
+    Floats det_d = ndx * minus_one - zero * ndy;
+    Floats y1 = (-ruy * nux - nuy * (g - rux)) / det_u;
+    Floats y2 = (-rdy * ndx - ndy * (g - rdx)) / det_d;
+
+    Floats u = select(y1 < y2, y2, y1);
+    Floats d = select(y2 < y1, y2, y1);
+    Mask off_goal =
+        (floats_set(-GOAL_WIDTH / 2) >= u) | (d >= floats_set(GOAL_WIDTH / 2));
+
+    int none = early | mask_bits(behind | off_goal);
+    int degenerate =
+        ~early & mask_bits((det == zero) | (det_u == zero) | (det_d == zero));
+    floats_store(us + l, u);
+    floats_store(ds + l, d);
+
+    for (int j = 0; j < SIMD_WIDTH && l + j < 2 * N_ROBOTS; j++) {
+      int i = l + j;
+      if (i == ignore_robot)
+        continue;
+
+      bool has_shadow;
+      if (degenerate & (1 << j)) {
+        Vector r = state.robots[i];
+        has_shadow = shadow_for_robot_from_pos(r, pos, gx, &shadows[count]);
+      } else {
+        has_shadow = !(none & (1 << j));
+        shadows[count] = {us[i], ds[i]};
+      }
+
+      if (has_shadow) {
+        if (robots)
+          robots[count] = i;
+        count++;
+      }
+    }
+  }
+
+  return count;
+}
+
+template <typename T> bool cmp_segments(BasicSegment<T> a, BasicSegment<T> b) {
   return a.u == b.u ? a.d > b.d : a.u > b.u;
 }
 
-void discover_gaps_from_pos(const State state, Vector pos, Player player,
-                            Segment *gaps, int *gaps_count_ptr,
-                            int ignore_robot) {
+template bool cmp_segments(Segment, Segment);
+template bool cmp_segments(BasicSegment<Dual>, BasicSegment<Dual>);
+
+// the SIMD lanes only take floats
+static bool simd_shadows(const State &state, Vector pos, float gx,
+                         Segment *shadows, int *shadows_count,
+                         int ignore_robot) {
+  if (!SIMD_SHADOWS)
+    return false;
+  *shadows_count =
+      shadows_from_pos(state, pos, gx, shadows, nullptr, ignore_robot);
+  return true;
+}
+
+static bool simd_shadows(const BasicState<Dual> &, BasicVector<Dual>, float,
+                         BasicSegment<Dual> *, int *, int) {
+  return false;
+}
+
+template <typename T>
+void discover_gaps_from_pos(const BasicState<T> &state, BasicVector<T> pos,
+                            Player player, BasicSegment<T> *gaps,
+                            int *gaps_count_ptr, int ignore_robot) {
 
   float gx = GOAL_X(player);
 
@@ -444,6 +689,11 @@ void discover_gaps_from_pos(const State state, Vector pos, Player player,
   // Segment shadows[2 * N_ROBOTS];
   auto shadows = gaps;
 
+  if (simd_shadows(state, pos, gx, shadows, &shadows_count, ignore_robot)) {
+    gaps_from_shadows(shadows, shadows_count, gaps_count_ptr);
+    return;
+  }
+
   FOR_EVERY_ROBOT(i) {
     if (i == ignore_robot)
       continue;
@@ -455,50 +705,65 @@ void discover_gaps_from_pos(const State state, Vector pos, Player player,
     // SQ(DEFENSE_RADIUS + MARG))
     //  continue;
 
-    Segment shadow;
+    BasicSegment<T> shadow;
     if (shadow_for_robot_from_pos(r, pos, gx, &shadow))
       shadows[shadows_count++] = shadow;
   }
 
-  // sort shadows in descending order by the first parameter (Segment.u)
-  std::sort(shadows, shadows + shadows_count, cmp_segments);
+  gaps_from_shadows(shadows, shadows_count, gaps_count_ptr);
+}
 
-  // merge shadows so no shadow overlap
-  Segment current_shadow;
-  int merged_count = 0;
-  bool has_first = false;
+template void discover_gaps_from_pos(const State &, Vector, Player, Segment *,
+                                     int *, int);
+template void discover_gaps_from_pos(const BasicState<Dual> &,
+                                     BasicVector<Dual>, Player,
+                                     BasicSegment<Dual> *, int *, int);
+
+template <typename T>
+void gaps_from_shadows(BasicSegment<T> *shadows, int shadows_count,
+                       int *gaps_count_ptr) {
+  // sort shadows in descending order by the first parameter (Segment.u), there
+  // are never more than a shadow per robot so a sorting network for the exact
+  // count does it
+  SortUpTo<2 * N_ROBOTS>::apply(shadows, shadows_count, cmp_segments<T>);
+  gaps_from_sorted_shadows(shadows, shadows_count, gaps_count_ptr);
+}
 
-  FOR_N(i, shadows_count) {
-    Segment shadow = shadows[i];
+template void gaps_from_shadows(Segment *, int, int *);
+template void gaps_from_shadows(BasicSegment<Dual> *, int, int *);
 
-    if (!has_first) {
-      current_shadow = shadow;
-      has_first = true;
-      continue;
-    }
+template <typename T>
+void gaps_from_sorted_shadows(BasicSegment<T> *shadows, int shadows_count,
+                              int *gaps_count_ptr) {
+  auto gaps = shadows;
 
-    if (shadow.d >= current_shadow.d) {
-      continue;
-    }
-
-    if (shadow.u >= current_shadow.d) {
-      current_shadow.d = shadow.d;
-    } else {
-      shadows[merged_count++] = current_shadow;
-      current_shadow = shadow;
+  // merge shadows so no shadow overlap; the current shadow is written on every
+  // step and only kept when the next one doesn't touch it, which can't be
+  // written over before it's read
+  int merged_count = 0;
+  if (shadows_count > 0) {
+    BasicSegment<T> current_shadow = shadows[0];
+
+    FOR_RANGE(i, 1, shadows_count) {
+      BasicSegment<T> shadow = shadows[i];
+      bool extends = !(shadow.d >= current_shadow.d);
+      bool disjoint = extends && !(shadow.u >= current_shadow.d);
+
+      shadows[merged_count] = current_shadow;
+      merged_count += disjoint;
+      current_shadow.u = disjoint ? shadow.u : current_shadow.u;
+      current_shadow.d = extends ? shadow.d : current_shadow.d;
     }
-  }
-  if (has_first) {
     shadows[merged_count++] = current_shadow;
   }
 
   // gather gaps on the goal from merged shadows
-  Segment current_gap = {GOAL_WIDTH / 2, -GOAL_WIDTH / 2};
+  BasicSegment<T> current_gap = {GOAL_WIDTH / 2, -GOAL_WIDTH / 2};
   int gaps_count = 0;
   bool has_last = true;
 
   FOR_N(i, merged_count) {
-    Segment shadow = shadows[i];
+    BasicSegment<T> shadow = shadows[i];
 
     if (shadow.u >= current_gap.u) {
       if (shadow.d <= current_gap.d) {
@@ -523,7 +788,10 @@ void discover_gaps_from_pos(const State state, Vector pos, Player player,
   *gaps_count_ptr = gaps_count;
 }
 
-float total_gap_len_from_pos(const State state, Vector pos, Player player,
+template void gaps_from_sorted_shadows(Segment *, int, int *);
+template void gaps_from_sorted_shadows(BasicSegment<Dual> *, int, int *);
+
+float total_gap_len_from_pos(const State &state, Vector pos, Player player,
                              int ignore_robot) {
   int gaps_count;
   Segment gaps[N_ROBOTS * 2]; // this should be enough
@@ -535,7 +803,7 @@ float total_gap_len_from_pos(const State state, Vector pos, Player player,
   return total_len;
 }
 
-float max_gap_len_from_pos(const State state, Vector pos, Player player,
+float max_gap_len_from_pos(const State &state, Vector pos, Player player,
                            int ignore_robot) {
   int gaps_count;
   Segment gaps[N_ROBOTS * 2]; // this should be enough
@@ -579,7 +847,7 @@ void update_from_proto(State &state, UpdateMessage &ptb_update,
   }
 }
 
-void discover_possible_receivers(const State state, const DecisionTable *table,
+void discover_possible_receivers(const State &state, const DecisionTable *table,
                                  Player player, TeamFilter &result,
                                  int passer) {
   // int rwb = robot_with_ball(state);
@@ -630,3 +898,105 @@ void discover_possible_receivers(const State state, const DecisionTable *table,
       filter_out(result, i);
   }
 }
+
+void discover_possible_receivers(const State &state, const DecisionTable *table,
+                                 TeamFilter *results, const int *passers) {
+  constexpr int LANES =
+      (2 * N_ROBOTS + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+
+  // receivers left after the cheap filters, as structure of arrays with the
+  // robots that may intercept a pass to each
+  int count = 0;
+  int receiver[LANES];
+  float move_x[LANES], move_y[LANES];
+  float icpt_x[N_ROBOTS][LANES], icpt_y[N_ROBOTS][LANES],
+      icpt_i[N_ROBOTS][LANES];
+
+  FOR_EVERY_ROBOT(i) {
+    Player player = PLAYER_OF(i);
+    auto &result = results[player];
+    int passer = passers[player];
+    if (result[i])
+      continue;
+
+    Vector move_pos = table ? table->move[i].move_pos : state.robots[i];
+
+    // same filters as above
+    if (norm2(move_pos - state.ball) > SQ(MAX_PASS_DISTANCE)) {
+      filter_out(result, i);
+      continue;
+    }
+
+    float robot_to_pos_time =
+        norm2(move_pos - state.robots[i]) / SQ(ROBOT_MAX_SPEED);
+    float ball_to_pos_time =
+        norm2(move_pos - state.ball) / SQ(ROBOT_KICK_SPEED);
+    float passer_to_ball_time =
+        passer >= 0
+            ? norm2(state.robots[passer] - state.ball) / SQ(ROBOT_MAX_SPEED)
+            : 0.0;
+    if (passer_to_ball_time + ball_to_pos_time < robot_to_pos_time) {
+      filter_out(result, i);
+      continue;
+    }
+
+    receiver[count] = i;
+    move_x[count] = move_pos.x;
+    move_y[count] = move_pos.y;
+    int j = 0;
+    FOR_TEAM_ROBOT(k, ENEMY_OF(player)) {
+      icpt_x[j][count] = state.robots[k].x;
+      icpt_y[j][count] = state.robots[k].y;
+      icpt_i[j][count] = k;
+      j++;
+    }
+    count++;
+  }
+
+  // padding lanes repeat the first receiver
+  int lanes = (count + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+  for (int l = count; l < lanes; l++) {
+    move_x[l] = move_x[0];
+    move_y[l] = move_y[0];
+    FOR_N(j, N_ROBOTS) {
+      icpt_x[j][l] = icpt_x[j][0];
+      icpt_y[j][l] = icpt_y[j][0];
+      icpt_i[j][l] = icpt_i[j][0];
+    }
+  }
+
+  // the ball is shared by every pass, only its direction changes
+  Floats bx = floats_set(state.ball.x), by = floats_set(state.ball.y);
+  Floats kick_speed = floats_set(ROBOT_KICK_SPEED);
+  Floats max_speed2 = floats_set(SQ(ROBOT_MAX_SPEED));
+
+  for (int l = 0; l < count; l += SIMD_WIDTH) {
+    Floats mx = floats_load(move_x + l), my = floats_load(move_y + l);
+
+    // unit(move_pos - state.ball) * ROBOT_KICK_SPEED
+    Floats dx = mx - bx, dy = my - by;
+    Floats n = floats_sqrt(dx * dx + dy * dy);
+    Floats bvx = dx / n * kick_speed, bvy = dy / n * kick_speed;
+    Floats a = max_speed2 - (bvx * bvx + bvy * bvy);
+
+    // can_receive_pass, -1 while the receiver is the first to get there
+    Floats min_time = time_to_pos_lanes(mx, my, bx, by, bvx, bvy, a);
+    Floats robot = floats_set(-1);
+    FOR_N(j, N_ROBOTS) {
+      Floats t =
+          time_to_pos_lanes(floats_load(icpt_x[j] + l),
+                            floats_load(icpt_y[j] + l), bx, by, bvx, bvy, a);
+      Mask better = t < min_time;
+      min_time = select(better, t, min_time);
+      robot = select(better, floats_load(icpt_i[j] + l), robot);
+    }
+
+    float vrobot[SIMD_WIDTH];
+    floats_store(vrobot, robot);
+    for (int k = 0; k < SIMD_WIDTH && l + k < count; k++) {
+      int i = receiver[l + k];
+      if (vrobot[k] >= 0 && vrobot[k] != i)
+        filter_out(results[PLAYER_OF(i)], i);
+    }
+  }
+}
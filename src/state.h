@@ -7,39 +7,106 @@
 #include "player.h"
 #include "segment.h"
 #include "filter.h"
+#include "simd.h"
 
-struct State {
-  Vector ball, ball_v;
-  GameArray<Vector> robots, robots_v;
+template <typename T> struct BasicState {
+  BasicVector<T> ball, ball_v;
+  GameArray<BasicVector<T>> robots, robots_v;
 };
 
+typedef BasicState<float> State;
+
+// the state with no derivatives, every coordinate a constant Dual, and back
+BasicState<Dual> dual_state(const State &state);
+inline const State &value_of(const State &state) { return state; }
+State value_of(const BasicState<Dual> &state);
+
 struct Decision;
 struct DecisionTable;
 
 State uniform_rand_state();
 
-bool can_kick_directly(const State state, Player player);
+bool can_kick_directly(const State &state, Player player);
 
-int robot_with_ball(const State state, float *time_min = nullptr,
-                    float *time_max = nullptr, int *robot_min = nullptr,
+// the same from the gaps on the enemy goal seen from the ball, without the
+// shadow of the robot with the ball
+bool can_kick_from_gaps(const State &state, Player player, const Segment *gaps,
+                        int gaps_count);
+
+// this and the others templated on the scalar are instantiated for float and
+// Dual
+template <typename T>
+int robot_with_ball(const BasicState<T> &state, T *time_min = nullptr,
+                    T *time_max = nullptr, int *robot_min = nullptr,
                     int *robot_max = nullptr);
 
-float total_gap_len_from_pos(const State state, Vector pos, Player player,
+float total_gap_len_from_pos(const State &state, Vector pos, Player player,
                              int ignore_robot = -1);
 
-float max_gap_len_from_pos(const State state, Vector pos, Player player,
+float max_gap_len_from_pos(const State &state, Vector pos, Player player,
                            int ignore_robot = -1);
 
-float time_to_pos(Vector robot_p, Vector robot_v, Vector pos, Vector pos_v,
-                  float max_speed = ROBOT_MAX_SPEED);
+template <typename T>
+T time_to_pos(BasicVector<T> robot_p, BasicVector<T> robot_v,
+              BasicVector<T> pos, BasicVector<T> pos_v,
+              float max_speed = ROBOT_MAX_SPEED);
+
+// time_to_pos on each lane, a = SQ(max_speed) - norm2(pos_v)
+Floats time_to_pos_lanes(Floats rx, Floats ry, Floats px, Floats py,
+                         Floats pvx, Floats pvy, Floats a);
+
+// with SIMD_SHADOWS floats take the shadows from shadows_from_pos
+template <typename T>
+void discover_gaps_from_pos(const BasicState<T> &state, BasicVector<T> pos,
+                            Player player, BasicSegment<T> *gaps,
+                            int *gaps_count, int ignore_robot = -1);
+
+// shadow of the robot at rpos on the goal at gx, seen from pos, false if none
+template <typename T>
+bool shadow_for_robot_from_pos(BasicVector<T> rpos, BasicVector<T> pos,
+                               float gx, BasicSegment<T> *shadow);
+
+struct ShadowGradient {
+  // derivatives of the u and d edges to the robot and to where it's seen from,
+  // edges at infinity have none
+  Vector du_rpos, du_pos, dd_rpos, dd_pos;
+};
+
+// for a shadow shadow_for_robot_from_pos finds
+void shadow_gradient(Vector rpos, Vector pos, float gx, ShadowGradient *grad);
+
+// derivative of time_to_pos to rpos, the one to pos is the opposite; none
+// where the time is constant
+Vector time_to_pos_gradient(Vector rpos, Vector pos, Vector pos_v,
+                            float max_speed = ROBOT_MAX_SPEED);
+
+// shadow_for_robot_from_pos for every robot, but ignore_robot, in SIMD lanes;
+// writes the shadows in robot order and the robot casting each if robots is
+// given, returns how many
+int shadows_from_pos(const State &state, Vector pos, float gx, Segment *shadows,
+                     int *robots = nullptr, int ignore_robot = -1);
 
-void discover_gaps_from_pos(const State state, Vector pos, Player player,
-                            Segment *gaps, int *gaps_count,
-                            int ignore_robot = -1);
+// merges the shadows on a goal and writes the gaps left over them, in place
+template <typename T>
+void gaps_from_shadows(BasicSegment<T> *shadows, int shadows_count,
+                       int *gaps_count);
 
-void discover_possible_receivers(const State state, const DecisionTable *table,
+// same as gaps_from_shadows, for shadows already sorted by cmp_segments
+template <typename T>
+void gaps_from_sorted_shadows(BasicSegment<T> *shadows, int shadows_count,
+                              int *gaps_count);
+
+// order of the shadows before merging, descending by u then by d
+template <typename T> bool cmp_segments(BasicSegment<T> a, BasicSegment<T> b);
+
+void discover_possible_receivers(const State &state, const DecisionTable *table,
                                  Player player, TeamFilter &result, int passer);
 
+// the same for both players at once, one receiver per SIMD lane; results and
+// passers are indexed by Player
+void discover_possible_receivers(const State &state, const DecisionTable *table,
+                                 TeamFilter *results, const int *passers);
+
 void update_from_proto(State &state, class UpdateMessage &ptb_update,
                        struct IdTable &table);
 
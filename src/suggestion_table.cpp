@@ -6,6 +6,7 @@
 #include "state.h"
 #include "vector.h"
 #include "action.h"
+#include "eval_context.h"
 
 int add_spot(SuggestionTable &table) {
   if (table.spots_count < MAX_SUGGESTION_SPOTS) {
@@ -21,16 +22,17 @@ int del_spot(SuggestionTable & /*table*/, int /*index*/) {
   return -1;
 }
 
-Decision gen_decision(bool kick, const SuggestionTable &table,
-                      const State *state, DecisionTable &dtable,
-                      Player player) {
+Decision gen_decision(const SuggestionTable &table, const EvalContext &ctx,
+                      DecisionTable &dtable) {
   // TODO: improve this algorithm, currently it gets a reasonable
   // solutions but
   // not the best
   Decision decision;
   bool filter[MAX_SUGGESTION_SPOTS] = {};
 
-  int rwb = robot_with_ball(*state);
+  const State *state = ctx.state;
+  Player player = ctx.player;
+  int rwb = ctx.rwb;
 
   FOR_TEAM_ROBOT(i, player) if (i != rwb) {
     auto pos = state->robots[i];
@@ -54,8 +56,8 @@ Decision gen_decision(bool kick, const SuggestionTable &table,
     }
   }
 
-  if (player == PLAYER_OF(rwb)) {
-    decision.action[rwb] = gen_primary_action(rwb, *state, dtable, kick);
+  if (ctx.has_ball) {
+    decision.action[rwb] = gen_primary_action(ctx, dtable);
   }
 
   return decision;
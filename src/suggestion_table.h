@@ -19,8 +19,8 @@ int add_spot(SuggestionTable &table);
 // delete given spot, return new size or -1 on failure
 int del_spot(SuggestionTable &table, int index);
 
-Decision gen_decision(bool kick, const SuggestionTable &table,
-                      const struct State *state, struct DecisionTable &dtable,
-                      Player player);
+Decision gen_decision(const SuggestionTable &table,
+                      const struct EvalContext &ctx,
+                      struct DecisionTable &dtable);
 
 #endif
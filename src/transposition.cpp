@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "transposition.h"
+#include "action.h"
+#include "utils.h"
+
+static_assert(N_ROBOTS <= 8, "the action types of a decision fill one word");
+
+// the features XORed into a key, the cells of robot i under ROBOT_FEATURE + i
+enum Feature { PLAYER_FEATURE, OWNER_FEATURE, BALL_FEATURE, ROBOT_FEATURE };
+
+// bit of the meta word set on every stored entry, so empty slots never match
+static constexpr uint64_t STORED = (uint64_t)1 << 56;
+
+// the finalizer of splitmix64, a random looking word for each x
+static uint64_t mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+  return x ^ (x >> 31);
+}
+
+static uint64_t feature_key(int feature, uint32_t a, uint32_t b = 0) {
+  return mix((uint64_t)feature << 56 ^ (uint64_t)a << 28 ^ b);
+}
+
+static uint64_t cell_key(int feature, Vector pos, float resolution) {
+  // far off the field every position is on the border cells
+  float x = std::min(std::max(pos.x, -FIELD_WIDTH), FIELD_WIDTH);
+  float y = std::min(std::max(pos.y, -FIELD_HEIGHT), FIELD_HEIGHT);
+  uint32_t cx = (int)std::floor(x / resolution);
+  uint32_t cy = (int)std::floor(y / resolution);
+  return feature_key(feature, cx & 0xfffffff, cy & 0xfffffff);
+}
+
+static uint32_t float_bits(float x) {
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  return bits;
+}
+
+static float bits_float(uint32_t bits) {
+  float x;
+  memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+// the word of the target of action, the receiver or a position
+static uint64_t action_word(const Action &action) {
+  switch (action.type) {
+  case MOVE:
+  case KICK:
+    return float_bits(action.move_pos.x) |
+           (uint64_t)float_bits(action.move_pos.y) << 32;
+  case PASS:
+    return (uint32_t)action.pass_receiver;
+  case NONE:
+    break;
+  }
+  return 0;
+}
+
+static Action word_action(ActionType type, uint64_t word) {
+  Vector pos(bits_float(word), bits_float(word >> 32));
+  switch (type) {
+  case MOVE:
+    return make_move_action(pos);
+  case KICK:
+    return make_kick_action(pos);
+  case PASS:
+    return make_pass_action((int)(uint32_t)word);
+  case NONE:
+    break;
+  }
+  return Action();
+}
+
+static void clear(TranspositionTable &table) {
+  FOR_N(i, TRANSPOSITION_TABLE_SIZE) {
+    for (auto &word : table.slots[i].words)
+      word.store(0, std::memory_order_relaxed);
+  }
+}
+
+void transposition_new_search(TranspositionTable &table, float resolution,
+                              uint64_t params) {
+  resolution = std::max(resolution, 0.01f);
+  if (!table.slots) {
+    table.slots.reset(new TranspositionSlot[TRANSPOSITION_TABLE_SIZE]);
+    clear(table);
+  } else if (table.resolution != resolution || table.params != params) {
+    clear(table);
+  }
+  table.resolution = resolution;
+  table.params = params;
+  // past the wrap the entries of 256 searches ago would pass as new ones
+  if (++table.generation == 0)
+    clear(table);
+}
+
+uint64_t transposition_key(const TranspositionTable &table, const State &state,
+                           Player player, int robot_with_ball) {
+  uint64_t key = feature_key(PLAYER_FEATURE, player) ^
+                 feature_key(OWNER_FEATURE, robot_with_ball + 1) ^
+                 cell_key(BALL_FEATURE, state.ball, table.resolution);
+  FOR_EVERY_ROBOT(i) {
+    key ^= cell_key(ROBOT_FEATURE + i, state.robots[i], table.resolution);
+  }
+  return key;
+}
+
+// the first word of an entry: unlike a plain XOR, words torn from entries that
+// differ the same way in several places don't cancel out
+static uint64_t entry_check(uint64_t key, const uint64_t *words) {
+  uint64_t check = key;
+  FOR_RANGE(i, 1, TRANSPOSITION_WORDS) { check = mix(check ^ words[i]); }
+  return check;
+}
+
+static TranspositionSlot &slot_of(const TranspositionTable &table,
+                                  uint64_t key) {
+  return table.slots[key & (TRANSPOSITION_TABLE_SIZE - 1)];
+}
+
+bool transposition_probe(const TranspositionTable &table, uint64_t key,
+                         TranspositionEntry *entry) {
+  auto &slot = slot_of(table, key);
+  uint64_t words[TRANSPOSITION_WORDS];
+  FOR_N(i, TRANSPOSITION_WORDS) {
+    words[i] = slot.words[i].load(std::memory_order_relaxed);
+  }
+  uint64_t meta = words[1];
+  if (!(meta & STORED) || words[0] != entry_check(key, words))
+    return false;
+  uint8_t generation = meta >> 48;
+  if ((uint8_t)(table.generation - generation) > TRANSPOSITION_MAX_AGE)
+    return false;
+
+  entry->value = bits_float(meta);
+  entry->depth = (meta >> 32) & 0xff;
+  entry->bound = (TranspositionBound)((meta >> 40) & 0xff);
+  entry->age = (uint8_t)(table.generation - generation);
+  FOR_N(i, N_ROBOTS) {
+    auto type = (ActionType)((words[2] >> 8 * i) & 0xff);
+    entry->decision.action[i] = word_action(type, words[3 + i]);
+  }
+  return true;
+}
+
+void transposition_store(TranspositionTable &table, uint64_t key,
+                         const TranspositionEntry &entry) {
+  auto &slot = slot_of(table, key);
+  uint64_t old = slot.words[1].load(std::memory_order_relaxed);
+  if ((uint8_t)(old >> 48) == table.generation &&
+      (int)((old >> 32) & 0xff) > entry.depth)
+    return;
+
+  uint64_t words[TRANSPOSITION_WORDS] = {};
+  words[1] = float_bits(entry.value) | (uint64_t)(entry.depth & 0xff) << 32 |
+             (uint64_t)entry.bound << 40 | (uint64_t)table.generation << 48 |
+             STORED;
+  FOR_N(i, N_ROBOTS) {
+    const Action &action = entry.decision.action[i];
+    words[2] |= (uint64_t)action.type << 8 * i;
+    words[3 + i] = action_word(action);
+  }
+  words[0] = entry_check(key, words);
+  FOR_N(i, TRANSPOSITION_WORDS) {
+    slot.words[i].store(words[i], std::memory_order_relaxed);
+  }
+}
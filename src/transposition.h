@@ -0,0 +1,71 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+
+#include "consts.h"
+#include "decision.h"
+#include "player.h"
+#include "state.h"
+
+// Fixed size table of searched states shared by the search threads without
+// locks. A state is keyed Zobrist style, XORing a random word for each of its
+// features: the player to move, the robot with the ball and the cells of the
+// ball and of every robot on a grid of the table resolution, so states closer
+// than a cell share an entry. An entry is a row of words stored and loaded one
+// by one, the first one a hash of the key and the others: an entry torn by a
+// concurrent store reads as a miss instead of mixing two results.
+// Entries remember the search that stored them, older ones are replaced first
+// and missed once more than TRANSPOSITION_MAX_AGE searches old.
+
+enum TranspositionBound { EXACT, LOWER, UPPER };
+
+struct TranspositionEntry {
+  float value = 0.0;
+  // plies searched below the state
+  int depth = 0;
+  // LOWER after a beta cutoff, UPPER if no decision reached alpha
+  TranspositionBound bound = EXACT;
+  // the best decision found for the player to move
+  Decision decision;
+  // searches since the one that stored it, read by the probe
+  int age = 0;
+};
+
+// check, bounds and age, action types, then a position per action
+constexpr int TRANSPOSITION_WORDS = 3 + N_ROBOTS;
+
+struct TranspositionSlot {
+  std::atomic<uint64_t> words[TRANSPOSITION_WORDS];
+};
+
+struct TranspositionTable {
+  // TRANSPOSITION_TABLE_SIZE slots, allocated by the first search
+  std::unique_ptr<TranspositionSlot[]> slots;
+  float resolution = 0.0;
+  // params_signature() of the values stored
+  uint64_t params = 0;
+  // the search entries are stored by, the table is cleared when it wraps
+  uint8_t generation = 0;
+};
+
+// starts a new search on the grid of resolution, keeping the entries of the
+// previous ones if the grid and the params, see params_signature(), are the
+// same: values of other weights can't be used for cutoffs
+void transposition_new_search(TranspositionTable &table, float resolution,
+                              uint64_t params);
+
+uint64_t transposition_key(const TranspositionTable &table, const State &state,
+                           Player player, int robot_with_ball);
+
+// false if key has no entry or too old a one
+bool transposition_probe(const TranspositionTable &table, uint64_t key,
+                         TranspositionEntry *entry);
+
+// keeps entry on the slot of key unless it holds a deeper entry of this search
+void transposition_store(TranspositionTable &table, uint64_t key,
+                         const TranspositionEntry &entry);
+
+#endif
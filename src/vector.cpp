@@ -1,49 +1,42 @@
 #include <cmath>
-#include <random>
 
+#include "rng.h"
 #include "vector.h"
 
-float norm2(const Vector v) { return v.x * v.x + v.y * v.y; }
-float norm(const Vector v) { return std::sqrt(norm2(v)); }
-Vector unit(const Vector v) { return v / norm(v); }
+template <typename T> T norm2(const BasicVector<T> v) {
+  return v.x * v.x + v.y * v.y;
+}
+template <typename T> T norm(const BasicVector<T> v) {
+  using std::sqrt;
+  return sqrt(norm2(v));
+}
+template <typename T> BasicVector<T> unit(const BasicVector<T> v) {
+  return v / norm(v);
+}
+template <typename T> T dist(const BasicVector<T> v1, const BasicVector<T> v2) {
+  return norm(v2 - v1);
+}
 
-static std::random_device _rd;
-static std::mt19937_64 generator(_rd());
+template float norm2(const Vector v);
+template float norm(const Vector v);
+template Vector unit(const Vector v);
+template float dist(const Vector v1, const Vector v2);
+template Dual norm2(const BasicVector<Dual> v);
+template Dual norm(const BasicVector<Dual> v);
+template BasicVector<Dual> unit(const BasicVector<Dual> v);
+template Dual dist(const BasicVector<Dual> v1, const BasicVector<Dual> v2);
 
 Vector uniform_rand_vector(float rx, float ry) {
-  std::uniform_real_distribution<float> xdistribution(-rx / 2, rx / 2),
-      ydistribution(-ry / 2, ry / 2);
-  return Vector(xdistribution(generator), ydistribution(generator));
+  Vector v;
+  rng_uniform_vectors(thread_rng(), &v, 1, rx, ry);
+  return v;
 }
 
 Vector normal_rand_vector(const Vector &v, float s) {
-  std::normal_distribution<float> distribution(0.0, s);
-  return v + Vector(distribution(generator), distribution(generator));
-}
-
-Vector rand_vector_bounded(const Vector _vec, float radius, float xb,
-                           float yb) {
-  Vector pos;
-  Vector vec(_vec);
-
-  if (std::abs(vec.x) > xb) {
-    vec *= xb / vec.x;
-  }
-  if (std::abs(vec.y) > yb) {
-    vec *= yb / vec.y;
-  }
-
-  static std::uniform_real_distribution<float> angle_dice(-M_PI, M_PI);
-  std::uniform_real_distribution<float> radius_dice(0, radius);
-
-  do {
-    float theta = angle_dice(generator);
-    float rand_r = radius_dice(generator);
-
-    pos = vec + Vector(rand_r * cos(theta), rand_r * sin(theta));
-  } while (std::abs(pos.x) > xb || std::abs(pos.y) > yb);
-
-  return pos;
+  Rng &rng = thread_rng();
+  float x = rng_normal(rng);
+  float y = rng_normal(rng);
+  return v + Vector(x * s, y * s);
 }
 
 bool line_segment_cross_circle(Vector p1, Vector p2, Vector c, float r) {
@@ -65,4 +58,3 @@ bool line_segment_cross_circle(Vector p1, Vector p2, Vector c, float r) {
     return false;
 }
 
-float dist(const Vector v1, const Vector v2) { return norm(v2 - v1); }
@@ -1,47 +1,66 @@
 #ifndef VECTOR_H
 #define VECTOR_H
 
-struct Vector {
-  float x, y;
+#include "dual.h"
 
-  constexpr Vector() : x(0), y(0) {}
-  constexpr Vector(const float x, const float y) : x(x), y(y) {}
-  constexpr Vector(const Vector &o) : x(o.x), y(o.y) {}
+// on any scalar, Vector on floats is the one used everywhere but the parts of
+// the evaluation that are differentiated with Dual
+template <typename T> struct BasicVector {
+  T x, y;
 
-  constexpr Vector operator+(const Vector &o) const {
-    return Vector(x + o.x, y + o.y);
+  constexpr BasicVector() : x(0), y(0) {}
+  constexpr BasicVector(const T x, const T y) : x(x), y(y) {}
+  constexpr BasicVector(const BasicVector &o) : x(o.x), y(o.y) {}
+  template <typename U>
+  constexpr BasicVector(const BasicVector<U> &o) : x(o.x), y(o.y) {}
+
+  constexpr BasicVector operator+(const BasicVector &o) const {
+    return BasicVector(x + o.x, y + o.y);
+  }
+  constexpr BasicVector operator-(const BasicVector &o) const {
+    return BasicVector(x - o.x, y - o.y);
+  }
+  constexpr BasicVector operator*(T k) const {
+    return BasicVector(x * k, y * k);
+  }
+  constexpr BasicVector operator/(T k) const {
+    return BasicVector(x / k, y / k);
   }
-  constexpr Vector operator-(const Vector &o) const {
-    return Vector(x - o.x, y - o.y);
+  constexpr T operator*(const BasicVector &o) const {
+    return x * o.x + y * o.y;
   }
-  constexpr Vector operator*(float k) const { return Vector(x * k, y * k); }
-  constexpr Vector operator/(float k) const { return Vector(x / k, y / k); }
-  constexpr float operator*(const Vector &o) const { return x * o.x + y * o.y; }
-  Vector operator+=(const Vector &o) {
+  BasicVector operator+=(const BasicVector &o) {
     x += o.x;
     y += o.y;
     return *this;
   }
-  Vector operator*=(float k) {
+  BasicVector operator*=(T k) {
     x *= k;
     y *= k;
     return *this;
   }
-  Vector operator/=(float k) {
+  BasicVector operator/=(T k) {
     x /= k;
     y /= k;
     return *this;
   }
 };
 
-float norm2(const Vector v);
-float norm(const Vector v);
-Vector unit(const Vector v);
+typedef BasicVector<float> Vector;
+
+// instantiated for float and Dual
+template <typename T> T norm2(const BasicVector<T> v);
+template <typename T> T norm(const BasicVector<T> v);
+template <typename T> BasicVector<T> unit(const BasicVector<T> v);
+template <typename T> T dist(const BasicVector<T> v1, const BasicVector<T> v2);
+
+inline const Vector &value_of(const Vector &v) { return v; }
+inline Vector value_of(const BasicVector<Dual> &v) {
+  return Vector(v.x.val, v.y.val);
+}
+
 Vector uniform_rand_vector(float rx, float ry);
 Vector normal_rand_vector(const Vector &v, float sigma = 1.0);
-Vector rand_vector_bounded(const Vector vec, float radius, float xbound,
-                           float ybound);
 bool line_segment_cross_circle(Vector p1, Vector p2, Vector c, float r);
-float dist(const Vector v1, const Vector v2);
 
 #endif
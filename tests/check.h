@@ -0,0 +1,27 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <cmath>
+#include <cstdio>
+
+// every test counts its failed checks here and returns nonzero if any
+static int failures = 0;
+
+#define CHECK_NEAR(A, B, TOL)                                                  \
+  do {                                                                         \
+    double _a = (A), _b = (B);                                                 \
+    if (!(std::fabs(_a - _b) <= (TOL))) {                                      \
+      printf("%s:%i: %s = %g, expected %g\n", __FILE__, __LINE__, #A, _a, _b); \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+#define CHECK(C)                                                               \
+  do {                                                                         \
+    if (!(C)) {                                                                \
+      printf("%s:%i: %s failed\n", __FILE__, __LINE__, #C);                    \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+#endif
@@ -0,0 +1,100 @@
+#include <cstdio>
+#include <algorithm>
+#include "optimization.h"
+#include "gradient.h"
+#include "decision.h"
+#include "decision_table.h"
+#include "eval_context.h"
+#include "action.h"
+#include "rng.h"
+#include "utils.h"
+#include "check.h"
+
+// Both gradients against central differences of evaluate_with_decision, on
+// fixed seed states. The objective has steps (who gets the ball first, which
+// robot bounds a gap), so differences at 4 and 16 mm are only trusted where
+// they agree with each other; there the gradients have to be within 5% plus
+// ABS_TOL. Steps just outside 4 mm still bend some of the differences, and the
+// analytic gradient smooths the steps, which leaves it off near ties of the
+// soft minimum: on 1000 states of other seeds the dual gradient agreed on
+// about 98% of the trusted components and the analytic one on about 97%.
+static constexpr float REL_TOL = 0.05, ABS_TOL = 0.05;
+static constexpr float MIN_ANALYTIC_AGREE = 0.95, MIN_DUAL_AGREE = 0.97;
+static constexpr float H_SMALL = 0.004, H_LARGE = 0.016;
+
+static bool near(float a, float b) {
+  return std::fabs(a - b) <= REL_TOL * std::max(std::fabs(a), std::fabs(b)) +
+                                 ABS_TOL;
+}
+
+static float central_difference(Player player, const State &state,
+                                Decision decision, const DecisionTable &table,
+                                int robot, Vector dir, float h) {
+  Vector pos = decision.action[robot].move_pos;
+  decision.action[robot].move_pos = pos + dir * h;
+  float plus = evaluate_with_decision(player, state, decision, table);
+  decision.action[robot].move_pos = pos + dir * -h;
+  float minus = evaluate_with_decision(player, state, decision, table);
+  return (plus - minus) / (2 * h);
+}
+
+int main(void) {
+  int trusted = 0, analytic_agree = 0, dual_agree = 0;
+
+  FOR_N(s, 200) {
+    rng_seed(thread_rng(), 31, s);
+    State state = uniform_rand_state();
+    Player player = s % 2 ? MAX : MIN;
+    DecisionTable table;
+    FOR_EVERY_ROBOT(i) {
+      table.move[i] = make_move_action(state.robots[i] +
+                                       uniform_rand_vector(1.5, 1.5));
+    }
+    EvalContext ctx;
+    eval_context_init(ctx, state, player);
+
+    FOR_N(k, 5) {
+      Decision decision = gen_decision(ctx, table);
+
+      ANALYTIC_GRADIENT = true;
+      Gradient analytic =
+          evaluate_with_decision_gradient(player, state, decision, table);
+      ANALYTIC_GRADIENT = false;
+      DUAL_GRADIENT = true;
+      Gradient dual =
+          evaluate_with_decision_gradient(player, state, decision, table);
+
+      FOR_TEAM_ROBOT(i, player) {
+        if (decision.action[i].type != MOVE) {
+          CHECK(analytic.deltas[i].x == 0 && analytic.deltas[i].y == 0);
+          CHECK(dual.deltas[i].x == 0 && dual.deltas[i].y == 0);
+          continue;
+        }
+        FOR_N(axis, 2) {
+          Vector dir = axis ? Vector(0, 1) : Vector(1, 0);
+          float fd = central_difference(player, state, decision, table, i,
+                                        dir, H_SMALL);
+          float fd_large = central_difference(player, state, decision, table,
+                                              i, dir, H_LARGE);
+          if (!near(fd, fd_large))
+            continue;
+          trusted++;
+          float a = axis ? analytic.deltas[i].y : analytic.deltas[i].x;
+          float d = axis ? dual.deltas[i].y : dual.deltas[i].x;
+          analytic_agree += near(a, fd);
+          dual_agree += near(d, fd);
+        }
+      }
+    }
+  }
+
+  printf("%i trusted components, analytic agrees on %i, dual on %i\n",
+         trusted, analytic_agree, dual_agree);
+  CHECK(trusted > 1000);
+  CHECK(analytic_agree >= MIN_ANALYTIC_AGREE * trusted);
+  CHECK(dual_agree >= MIN_DUAL_AGREE * trusted);
+
+  if (failures)
+    printf("%i checks failed\n", failures);
+  return failures ? 1 : 0;
+}
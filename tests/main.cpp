@@ -1,61 +1,90 @@
-#include "move_solver.h"
+#include <cstdio>
+#include "numerical_methods.h"
+#include "check.h"
 
-num f(const vec x) { 
-  if (x.size() < 2) exit(1);
+using namespace numerical_method;
 
-  return pow(x(0), 3) - 12 * x(0) * x(1) + pow(x(1), 3)
-         - 63 * (x(0) + x(1));
+// stationary points: minimum at (7, 7), maximum at (-3, -3) and saddles on
+// x + y = -4
+num f(const vec<2> x) {
+  return pow(x(0), 3) - 12 * x(0) * x(1) + pow(x(1), 3) - 63 * (x(0) + x(1));
 }
 
 int main(void) {
-  num gamma = 0.05, erro,
-      eig_min,   eig_max;
-
-  mat H;
-
-  int info;
-  vec x (2), x1(2), sol(2), sol_nwtn(2);
-  x  <<= M_PI_2, 0;
-  x1 <<=      0, 0;
-
-  tie(sol, erro)                = grad_min (f, x, gamma);
-  tie(H, eig_min, eig_max,info) = hessian  (f, x);
-  cout <<  "hessian matrix: " << H          << endl;
-
-  tie(H, eig_min, eig_max,info) = hessian  (f, x1);
-
-  // testing matrix_div with vectors
-  mat A(3,3),_b(3,1); vec b(3);
-  size_t _r;
-  A <<= 1, 0, 0, 0, 1, 0, 0, 0, 1;
-  b <<= 2, 3, 4;
-  // transform vector to matrix
-  copy(b.begin(), b.end(), _b.begin1());
-
-  cout << "x  = " << x                      << endl
-       << "x1 = " << x1                     << endl
-       << "grad(f, x)  = "  << grad (f, x)  << endl
-       << "grad(f, x1) = "  << grad (f, x1) << endl
-       << "grad_min(f, x, " << gamma << ") = "
-       << sol << " with error = " << erro   << endl
-       << "hessian matrix: " << H           << endl
-       << "eig max: " << eig_min            << endl
-       << "eig min: " << eig_max            << endl
-       << "A.x = b: "<< matrix_div(A, _b, _r) << endl;
-
-  tie(sol_nwtn, erro, eig_min, eig_max, info) = newton_min (f, x1);
-  cout << "newton_min(f,x1): " << sol_nwtn  << endl
-       << "erro: "    << erro               << endl
-       << "eig max: " << eig_min            << endl
-       << "eig min: " << eig_max            << endl;
-
-  tie(sol_nwtn, erro) = newton_grad (f, x1, gamma, true);
-  cout << "newton_grad (f,x1): " << sol_nwtn << endl
-       << "erro: "    << erro                << endl;
-
-  tie(sol_nwtn, erro) = newton_grad (f, x1, gamma, false);
-  cout << "newton_grad (f,x1): " << sol_nwtn << endl
-       << "erro: "    << erro                << endl;
-
-  return 0;
+  num gamma = 0.05, erro, eig_min, eig_max;
+
+  mat<2> H;
+  vec<2> x, x1, sol, sol_nwtn;
+  x(0) = M_PI_2;
+
+  // grad(f) = (3x² - 12y - 63, 3y² - 12x - 63)
+  vec<2> g = grad(f, x);
+  CHECK_NEAR(g(0), 3 * M_PI_2 * M_PI_2 - 63, 1e-6);
+  CHECK_NEAR(g(1), -12 * M_PI_2 - 63, 1e-6);
+  g = grad(f, x1);
+  CHECK_NEAR(g(0), -63, 1e-6);
+  CHECK_NEAR(g(1), -63, 1e-6);
+
+  // hessian(f) = [6x -12; -12 6y]
+  tie(H, eig_min, eig_max) = hessian(f, x);
+  CHECK_NEAR(H(0, 0), 6 * M_PI_2, 1e-3);
+  CHECK_NEAR(H(0, 1), -12, 1e-3);
+  CHECK_NEAR(H(1, 0), -12, 1e-3);
+  CHECK_NEAR(H(1, 1), 0, 1e-3);
+  CHECK_NEAR(eig_min + eig_max, 6 * M_PI_2, 1e-3);
+  CHECK_NEAR(eig_min * eig_max, -144, 1e-2);
+  tie(H, eig_min, eig_max) = hessian(f, x1);
+  CHECK_NEAR(eig_min, -12, 1e-3);
+  CHECK_NEAR(eig_max, 12, 1e-3);
+
+  // descending from (π/2, 0) ends on the minimum
+  tie(sol, erro) = grad_min(f, x, -gamma / 10);
+  CHECK_NEAR(sol(0), 7, 1e-2);
+  CHECK_NEAR(sol(1), 7, 1e-2);
+
+  // testing solve with vectors
+  mat<3> A = identity<3>();
+  vec<3> b, b_sol;
+  b(0) = 2, b(1) = 3, b(2) = 4;
+  CHECK(solve(A, b, b_sol));
+  CHECK_NEAR(b_sol(0), 2, 1e-12);
+  CHECK_NEAR(b_sol(1), 3, 1e-12);
+  CHECK_NEAR(b_sol(2), 4, 1e-12);
+  CHECK(cholesky_solve(A, b, b_sol));
+  CHECK_NEAR(b_sol(2), 4, 1e-12);
+  A(0, 1) = A(1, 0) = 2;
+  CHECK(solve(A, b, b_sol));
+  CHECK_NEAR(b_sol(0) + 2 * b_sol(1), 2, 1e-12);
+  CHECK(!cholesky_solve(A, b, b_sol));
+
+  // newton finds the closest stationary point, the maximum
+  tie(sol_nwtn, erro, eig_min, eig_max) = newton_min(f, x1);
+  CHECK_NEAR(sol_nwtn(0), -3, 1e-3);
+  CHECK_NEAR(sol_nwtn(1), -3, 1e-3);
+  CHECK(eig_max < 0);
+
+  tie(sol_nwtn, erro) = newton_grad(f, x1, gamma, true);
+  CHECK_NEAR(sol_nwtn(0), 7, 1e-3);
+  CHECK_NEAR(sol_nwtn(1), 7, 1e-3);
+
+  tie(sol_nwtn, erro) = newton_grad(f, x1, gamma, false);
+  CHECK_NEAR(sol_nwtn(0), -3, 1e-3);
+  CHECK_NEAR(sol_nwtn(1), -3, 1e-3);
+
+  // bfgs on a quadratic recovers the inverse hessian after N steps
+  mat<2> Q, H_inv = identity<2>();
+  Q(0, 0) = 4, Q(0, 1) = Q(1, 0) = 1, Q(1, 1) = 3;
+  vec<2> s, e0, e1;
+  e0(0) = 1, e1(1) = 1;
+  CHECK(bfgs_update(H_inv, e0, Q * e0));
+  s = H_inv * e1;
+  CHECK(bfgs_update(H_inv, s, Q * s));
+  vec<2> r = Q * (H_inv * e0);
+  CHECK_NEAR(r(0), 1, 1e-9);
+  CHECK_NEAR(r(1), 0, 1e-9);
+  CHECK(!bfgs_update(H_inv, e0, -1.0 * e0));
+
+  if (failures)
+    printf("%i checks failed\n", failures);
+  return failures ? 1 : 0;
 }
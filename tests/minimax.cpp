@@ -0,0 +1,65 @@
+#include <cstdio>
+#include <cstring>
+#include "minimax.h"
+#include "action.h"
+#include "rng.h"
+#include "utils.h"
+#include "check.h"
+
+// PRUNE_EVALUATION only cuts leaves that can't change the search, so with the
+// same seed a search with it finds the same first ply decision and value as
+// one without, over several ticks sharing the transposition table
+static constexpr int STATES = 40, TICKS = 4;
+
+static bool same_decision(const Decision &a, const Decision &b) {
+  FOR_EVERY_ROBOT(i) {
+    const Action &x = a.action[i], &y = b.action[i];
+    if (x.type != y.type)
+      return false;
+    if ((x.type == MOVE || x.type == KICK) &&
+        (x.move_pos.x != y.move_pos.x || x.move_pos.y != y.move_pos.y))
+      return false;
+    if (x.type == PASS && x.pass_receiver != y.pass_receiver)
+      return false;
+  }
+  return true;
+}
+
+int main(void) {
+  CONSTANT_RATE = false;
+  RAMIFICATION_NUMBER = 100;
+  MINIMAX_BRANCHING = 4;
+  MAX_DEPTH = 3;
+  DECISION_THREADS = 1;
+  TRANSPOSITION_TABLE = true;
+  long pruned = 0;
+
+  FOR_N(s, STATES) {
+    DECISION_SEED = 1 + s;
+    rng_seed(thread_rng(), 41, s);
+    State state = uniform_rand_state();
+    Player player = s % 2 ? MAX : MIN;
+
+    static Minimax pruning, full;
+    pruning = Minimax();
+    full = Minimax();
+    FOR_N(tick, TICKS) {
+      PRUNE_EVALUATION = true;
+      ValuedDecision a = minimax_decide(pruning, state, player);
+      pruned += pruning.stats.pruned;
+      PRUNE_EVALUATION = false;
+      ValuedDecision b = minimax_decide(full, state, player);
+
+      CHECK(a.value == b.value);
+      CHECK(same_decision(a.decision, b.decision));
+      apply_to_state(a.decision, player, &state);
+    }
+  }
+
+  printf("%li leaves pruned\n", pruned);
+  CHECK(pruned > 0);
+
+  if (failures)
+    printf("%i checks failed\n", failures);
+  return failures ? 1 : 0;
+}
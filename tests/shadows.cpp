@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <algorithm>
+#include "state.h"
+#include "rng.h"
+#include "utils.h"
+#include "check.h"
+
+// shadows_from_pos runs the scalar steps lane by lane and redoes degenerate
+// lanes with shadow_for_robot_from_pos, so both should agree to the last bit;
+// a micrometer leaves room for compilers contracting the lanes differently
+static constexpr float TOL = 1e-6;
+
+static bool same_edge(float a, float b) {
+  return a == b || std::fabs(a - b) <= TOL;
+}
+
+// the SIMD shadows of pos against shadow_for_robot_from_pos on every robot
+static void check_shadows(const State &state, Vector pos, float gx,
+                          int ignore_robot = -1) {
+  Segment shadows[2 * N_ROBOTS];
+  int robots[2 * N_ROBOTS];
+  int count =
+      shadows_from_pos(state, pos, gx, shadows, robots, ignore_robot);
+
+  int n = 0;
+  FOR_EVERY_ROBOT(i) {
+    Segment s;
+    if (i == ignore_robot ||
+        !shadow_for_robot_from_pos(state.robots[i], pos, gx, &s))
+      continue;
+    if (n < count) {
+      CHECK(robots[n] == i);
+      CHECK(same_edge(shadows[n].u, s.u));
+      CHECK(same_edge(shadows[n].d, s.d));
+    }
+    n++;
+  }
+  CHECK(count == n);
+}
+
+static void check_gaps(const State &state, Vector pos, Player player) {
+  Segment simd[2 * N_ROBOTS + 1], scalar[2 * N_ROBOTS + 1];
+  int simd_count, scalar_count;
+  SIMD_SHADOWS = true;
+  discover_gaps_from_pos(state, pos, player, simd, &simd_count);
+  SIMD_SHADOWS = false;
+  discover_gaps_from_pos(state, pos, player, scalar, &scalar_count);
+  CHECK(simd_count == scalar_count);
+  FOR_N(k, std::min(simd_count, scalar_count)) {
+    CHECK(same_edge(simd[k].u, scalar[k].u));
+    CHECK(same_edge(simd[k].d, scalar[k].d));
+  }
+}
+
+int main(void) {
+  const float goals[] = {-FIELD_WIDTH / 2, FIELD_WIDTH / 2};
+
+  FOR_N(s, 2000) {
+    rng_seed(thread_rng(), 11, s);
+    State state = uniform_rand_state();
+    Vector pos = uniform_rand_vector(FIELD_WIDTH, FIELD_HEIGHT);
+    for (float gx : goals) {
+      check_shadows(state, pos, gx);
+      check_shadows(state, pos, gx, s % (2 * N_ROBOTS));
+      // from the ball, and from a robot ignoring itself
+      check_shadows(state, state.ball, gx);
+      check_shadows(state, state.robots[s % (2 * N_ROBOTS)], gx,
+                    s % (2 * N_ROBOTS));
+    }
+    check_gaps(state, pos, s % 2 ? MAX : MIN);
+  }
+
+  FOR_N(s, 200) {
+    rng_seed(thread_rng(), 12, s);
+    State state = uniform_rand_state();
+    Vector pos = uniform_rand_vector(FIELD_WIDTH, FIELD_HEIGHT);
+    // a robot on the query point and one inside its radius
+    state.robots[0] = pos;
+    state.robots[1] = pos + Vector(ROBOT_RADIUS / 2, 0);
+    // robots aligned with the query point, on the same row and column
+    FOR_RANGE(i, 2, 6) { state.robots[i] = pos + Vector(0.3 * (i - 1), 0); }
+    FOR_RANGE(i, 6, 9) { state.robots[i] = pos + Vector(0, 0.3 * (i - 5)); }
+    // and on a diagonal
+    FOR_RANGE(i, 9, 2 * N_ROBOTS) {
+      state.robots[i] = pos + Vector(-0.4, 0.4) * (i - 8);
+    }
+    for (float gx : goals) {
+      check_shadows(state, pos, gx);
+      FOR_EVERY_ROBOT(i) { check_shadows(state, pos, gx, i); }
+    }
+    check_gaps(state, pos, MAX);
+    check_gaps(state, pos, MIN);
+  }
+
+  if (failures)
+    printf("%i checks failed\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,47 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <initializer_list>
+#include "state.h"
+#include "rng.h"
+#include "utils.h"
+
+// ns per discover_gaps_from_pos call with and without SIMD_SHADOWS, on the
+// same random states and query points
+int main(void) {
+  using namespace std::chrono;
+  constexpr int STATES = 1000, QUERIES = 400, ROUNDS = 5;
+
+  static State states[STATES];
+  static Vector queries[QUERIES];
+  rng_seed(thread_rng(), 21);
+  FOR_N(s, STATES) { states[s] = uniform_rand_state(); }
+  FOR_N(q, QUERIES) {
+    queries[q] = uniform_rand_vector(FIELD_WIDTH, FIELD_HEIGHT);
+  }
+
+  for (bool simd : {false, true}) {
+    SIMD_SHADOWS = simd;
+    double best = 1e9;
+    // counted so the calls can't be optimized out
+    long total = 0;
+    FOR_N(round, ROUNDS) {
+      auto start = steady_clock::now();
+      FOR_N(s, STATES) {
+        FOR_N(q, QUERIES) {
+          Segment gaps[2 * N_ROBOTS + 1];
+          int gaps_count;
+          discover_gaps_from_pos(states[s], queries[q], q % 2 ? MAX : MIN,
+                                 gaps, &gaps_count);
+          total += gaps_count;
+        }
+      }
+      double ns = duration<double, std::nano>(steady_clock::now() - start)
+                      .count() /
+                  (STATES * QUERIES);
+      best = std::min(best, ns);
+    }
+    printf("SIMD_SHADOWS %d: %.1f ns/call (%ld gaps)\n", simd, best, total);
+  }
+  return 0;
+}